@@ -1,6 +1,65 @@
 #ifndef __ARM_PERCPU
 #define __ARM_PERCPU
 
+#include <linux/types.h>
+
 #include <asm-generic/percpu.h>
 
+#ifndef CONFIG_GENERIC_ATOMIC64
+/*
+ * Double word cmpxchg on this cpu's area using ldrexd/strexd, as used by
+ * the SLUB fastpaths.  An interrupt between the load and the store clears
+ * the exclusive monitor on exception return, so the store fails and we go
+ * round again: there is no need to disable interrupts.  No barriers either,
+ * nobody else writes to this cpu's area.
+ */
+static inline bool __arm_cpu_cmpxchg_double(void *ptr,
+					    unsigned long o1, unsigned long o2,
+					    unsigned long n1, unsigned long n2)
+{
+	union {
+		u64 v;
+		unsigned long w[2];
+	} old, new;
+	u64 cur;
+	unsigned long res;
+
+	old.w[0] = o1;
+	old.w[1] = o2;
+	new.w[0] = n1;
+	new.w[1] = n2;
+
+	do {
+		__asm__ __volatile__("@ __arm_cpu_cmpxchg_double\n"
+		"ldrexd		%1, %H1, [%2]\n"
+		"mov		%0, #0\n"
+		"teq		%1, %3\n"
+		"teqeq		%H1, %H3\n"
+		"strexdeq	%0, %4, %H4, [%2]"
+		: "=&r" (res), "=&r" (cur)
+		: "r" (ptr), "r" (old.v), "r" (new.v)
+		: "cc", "memory");
+	} while (res);
+
+	return cur == old.v;
+}
+
+/* Preemption is only disabled so that the address stays this cpu's. */
+#define __arm_pcpu_cmpxchg_double(pcp1, o1, o2, n1, n2)			\
+({									\
+	bool ret__;							\
+	preempt_disable();						\
+	ret__ = __arm_cpu_cmpxchg_double(__this_cpu_ptr(&(pcp1)),	\
+			(unsigned long)(o1), (unsigned long)(o2),	\
+			(unsigned long)(n1), (unsigned long)(n2));	\
+	preempt_enable();						\
+	ret__;								\
+})
+
+#define this_cpu_cmpxchg_double_4(pcp1, pcp2, o1, o2, n1, n2)		\
+	__arm_pcpu_cmpxchg_double(pcp1, o1, o2, n1, n2)
+#define irqsafe_cpu_cmpxchg_double_4(pcp1, pcp2, o1, o2, n1, n2)	\
+	__arm_pcpu_cmpxchg_double(pcp1, o1, o2, n1, n2)
+#endif /* !CONFIG_GENERIC_ATOMIC64 */
+
 #endif
@@ -78,6 +78,12 @@
 #define PTE_EXT_SHARED		(1 << 10)	/* v6 */
 #define PTE_EXT_NG		(1 << 11)	/* v6 */
 
+/*
+ *   - extended large page (v6)
+ */
+#define PTE_LARGE_TEX(x)	((x) << 12)
+#define PTE_LARGE_XN		(1 << 15)
+
 /*
  *   - small page
  */
@@ -374,7 +374,46 @@ static inline pte_t *pmd_page_vaddr(pmd_t pmd)
 #define mk_pte(page,prot)	pfn_pte(page_to_pfn(page), prot)
 
 #define set_pte_ext(ptep,pte,ext) cpu_set_pte_ext(ptep,pte,ext)
-#define pte_clear(mm,addr,ptep)	set_pte_ext(ptep, __pte(0), 0)
+
+#ifdef CONFIG_ANON_LARGE_PAGES
+/*
+ * Anonymous memory may be mapped with 64K large pages, LARGE_PTE_NR equal
+ * entries in the h/w pt.  The Linux pt is unaffected and still describes
+ * every page on its own, see arch/arm/mm/largepte.c.
+ */
+#define LARGE_PTE_SHIFT		16
+#define LARGE_PTE_SIZE		(1UL << LARGE_PTE_SHIFT)
+#define LARGE_PTE_MASK		(~(LARGE_PTE_SIZE-1))
+#define LARGE_PTE_NR		(LARGE_PTE_SIZE >> PAGE_SHIFT)
+
+struct mm_struct;
+struct vm_area_struct;
+extern int make_large_pte(struct vm_area_struct *vma, unsigned long addr,
+			  pte_t *ptep);
+extern void __split_large_pte(struct mm_struct *mm, unsigned long addr,
+			      pte_t *ptep);
+
+/* Go back to small pages before any pte of a large page is changed. */
+static inline void split_large_pte(struct mm_struct *mm, unsigned long addr,
+				   pte_t *ptep)
+{
+	u32 hw = *(u32 *)(ptep + PTE_HWTABLE_PTRS);
+
+	if (unlikely((hw & PTE_TYPE_MASK) == PTE_TYPE_LARGE))
+		__split_large_pte(mm, addr, ptep);
+}
+#else
+static inline void split_large_pte(struct mm_struct *mm, unsigned long addr,
+				   pte_t *ptep)
+{
+}
+#endif
+
+#define pte_clear(mm,addr,ptep)				\
+	do {						\
+		split_large_pte(mm, addr, ptep);	\
+		set_pte_ext(ptep, __pte(0), 0);		\
+	} while (0)
 
 #define pte_none(pte)		(!pte_val(pte))
 #define pte_present(pte)	(pte_val(pte) & L_PTE_PRESENT)
@@ -401,6 +440,7 @@ static inline void set_pte_at(struct mm_struct *mm, unsigned long addr,
 {
 	unsigned long ext = 0;
 
+	split_large_pte(mm, addr, ptep);
 	if (addr < TASK_SIZE && pte_present_user(pteval)) {
 		__sync_icache_dcache(pteval);
 		ext |= PTE_EXT_NG;
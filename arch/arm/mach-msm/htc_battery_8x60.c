@@ -1035,6 +1035,7 @@ static int htc_battery_probe(struct platform_device *pdev)
 	early_suspend.level = EARLY_SUSPEND_LEVEL_BLANK_SCREEN + 2;
 	early_suspend.suspend = htc_battery_early_suspend;
 	early_suspend.resume = htc_battery_late_resume;
+	early_suspend.flags = EARLY_SUSPEND_ASYNC;
 	register_early_suspend(&early_suspend);
 #endif
 #endif
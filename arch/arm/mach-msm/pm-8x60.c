@@ -24,6 +24,7 @@
 #include <linux/proc_fs.h>
 #include <linux/smp.h>
 #include <linux/suspend.h>
+#include <linux/suspend_profile.h>
 #include <linux/tick.h>
 #include <linux/uaccess.h>
 #include <linux/wakelock.h>
@@ -1052,6 +1053,8 @@ static int msm_pm_enter(suspend_state_t state)
 	int64_t time = msm_timer_get_sclk_time(&period);
 #endif
 
+	suspend_prof_stage_begin(SUSPEND_PROF_PLATFORM_ENTER);
+
 	if (MSM_PM_DEBUG_SUSPEND & msm_pm_debug_mask)
 		pr_info("%s\n", __func__);
 
@@ -1126,7 +1129,13 @@ static int msm_pm_enter(suspend_state_t state)
 			ret = msm_rpmrs_enter_sleep(
 				msm_pm_max_sleep_time, rs_limits, false, true);
 			if (!ret) {
-				int collapsed = msm_pm_power_collapse(false);
+				int collapsed;
+
+				suspend_prof_stage_end(
+					SUSPEND_PROF_PLATFORM_ENTER);
+				collapsed = msm_pm_power_collapse(false);
+				suspend_prof_stage_begin(
+					SUSPEND_PROF_PLATFORM_EXIT);
 				msm_rpmrs_exit_sleep(rs_limits, false, true,
 						collapsed);
 			}
@@ -1151,7 +1160,9 @@ static int msm_pm_enter(suspend_state_t state)
 	} else if (allow[MSM_PM_SLEEP_MODE_POWER_COLLAPSE_STANDALONE]) {
 		if (MSM_PM_DEBUG_SUSPEND & msm_pm_debug_mask)
 			pr_info("%s: standalone power collapse\n", __func__);
+		suspend_prof_stage_end(SUSPEND_PROF_PLATFORM_ENTER);
 		msm_pm_power_collapse_standalone(false);
+		suspend_prof_stage_begin(SUSPEND_PROF_PLATFORM_EXIT);
 	} else if (allow[MSM_PM_SLEEP_MODE_WAIT_FOR_INTERRUPT]) {
 		if (MSM_PM_DEBUG_SUSPEND & msm_pm_debug_mask)
 			pr_info("%s: swfi\n", __func__);
@@ -1164,7 +1175,9 @@ static int msm_pm_enter(suspend_state_t state)
 #endif
 
 		printk(KERN_INFO "[R] suspend end\n");
+		suspend_prof_stage_end(SUSPEND_PROF_PLATFORM_ENTER);
 		msm_pm_swfi();
+		suspend_prof_stage_begin(SUSPEND_PROF_PLATFORM_EXIT);
 		printk(KERN_INFO "[R] resume start\n");
 
 #ifdef CONFIG_MSM_WATCHDOG
@@ -1183,6 +1196,14 @@ enter_exit:
 	if (MSM_PM_DEBUG_SUSPEND & msm_pm_debug_mask)
 		pr_info("%s: return\n", __func__);
 
+	/*
+	 * Still open if we never got to power collapse, e.g. when
+	 * msm_rpmrs_enter_sleep() failed: all of ->enter() was then spent
+	 * awake.  Either end is a no-op for a stage that is not open.
+	 */
+	suspend_prof_stage_end(SUSPEND_PROF_PLATFORM_ENTER);
+	suspend_prof_stage_end(SUSPEND_PROF_PLATFORM_EXIT);
+
 	return 0;
 }
 
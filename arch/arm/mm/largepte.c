@@ -0,0 +1,109 @@
+/*
+ *  linux/arch/arm/mm/largepte.c
+ *
+ *  64K large page mappings of anonymous memory.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * A large page is described by LARGE_PTE_NR identical descriptors in the
+ * h/w pt, each of which must carry the same attributes and the physical
+ * base of the whole block.  Only the h/w pt knows about it: the Linux pt
+ * keeps describing every 4K page, so the generic VM, which only ever
+ * writes Linux ptes through set_pte_at() and pte_clear(), goes on working
+ * on the individual pages.  Those two split the block into small pages
+ * first whenever one of its ptes changes.
+ *
+ * The architecture leaves it UNPREDICTABLE which translation is used if
+ * the TLB holds both a large and a small entry for an address, so both
+ * directions go through invalid entries and a TLB flush.
+ */
+#include <linux/mm.h>
+#include <linux/vmstat.h>
+
+#include <asm/cacheflush.h>
+#include <asm/pgtable.h>
+#include <asm/tlbflush.h>
+
+#define LARGE_HW_SIZE	(LARGE_PTE_NR * sizeof(u32))
+
+static inline u32 *hw_ptes(pte_t *ptep)
+{
+	return (u32 *)(ptep + PTE_HWTABLE_PTRS);
+}
+
+static void clear_hw_ptes(u32 *hw)
+{
+	memset(hw, 0, LARGE_HW_SIZE);
+	clean_dcache_area(hw, LARGE_HW_SIZE);
+}
+
+/*
+ * Turn the LARGE_PTE_NR small page descriptors starting at @ptep into a
+ * large page, provided they map a naturally aligned, physically contiguous
+ * block with identical attributes.  This is only the case while all of the
+ * Linux ptes are present, young and equally dirty and writable.
+ *
+ * Called with the pte lock held.  Returns 1 if the block is now large.
+ */
+int make_large_pte(struct vm_area_struct *vma, unsigned long addr,
+		   pte_t *ptep)
+{
+	u32 *hw = hw_ptes(ptep);
+	u32 small = hw[0], large;
+	int i;
+
+	/*
+	 * A small page descriptor is identified by bit 1 alone: bit 0 is
+	 * XN, which every non-executable mapping, most anonymous memory
+	 * included, has set.
+	 */
+	if (!(small & PTE_TYPE_SMALL) ||
+	    (small & ~LARGE_PTE_MASK & PAGE_MASK))
+		return 0;
+
+	/* Same attributes, XN included, on consecutive physical pages */
+	for (i = 1; i < LARGE_PTE_NR; i++)
+		if (hw[i] != small + (i << PAGE_SHIFT))
+			return 0;
+
+	/* In a large page descriptor XN moves to bit 15 and TEX to 14:12 */
+	large = (small & LARGE_PTE_MASK) | PTE_TYPE_LARGE;
+	large |= small & (PTE_BUFFERABLE | PTE_CACHEABLE | PTE_EXT_AP_MASK |
+			  PTE_EXT_APX | PTE_EXT_SHARED | PTE_EXT_NG);
+	large |= PTE_LARGE_TEX((small >> 6) & 7);
+	if (small & PTE_EXT_XN)
+		large |= PTE_LARGE_XN;
+
+	clear_hw_ptes(hw);
+	flush_tlb_range(vma, addr, addr + LARGE_PTE_SIZE);
+
+	for (i = 0; i < LARGE_PTE_NR; i++)
+		hw[i] = large;
+	clean_dcache_area(hw, LARGE_HW_SIZE);
+	return 1;
+}
+
+/*
+ * Rewrite the large page around @ptep as small pages from the Linux ptes.
+ * There is no vma at hand in set_pte_at(), but the TLB maintenance only
+ * looks at vm_mm, so a dummy one limits the flush to the block instead of
+ * the whole address space.
+ */
+void __split_large_pte(struct mm_struct *mm, unsigned long addr, pte_t *ptep)
+{
+	pte_t *start = ptep - (pte_index(addr) & (LARGE_PTE_NR - 1));
+	struct vm_area_struct vma;
+	int i;
+
+	vma.vm_mm = mm;
+	addr &= LARGE_PTE_MASK;
+
+	clear_hw_ptes(hw_ptes(start));
+	flush_tlb_range(&vma, addr, addr + LARGE_PTE_SIZE);
+
+	for (i = 0; i < LARGE_PTE_NR; i++)
+		set_pte_ext(start + i, start[i], PTE_EXT_NG);
+	count_vm_event(ANON_LARGE_SPLIT);
+}
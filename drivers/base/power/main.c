@@ -27,6 +27,7 @@
 #include <linux/sched.h>
 #include <linux/async.h>
 #include <linux/suspend.h>
+#include <linux/suspend_profile.h>
 #include <linux/timer.h>
 
 #include "../base.h"
@@ -226,8 +227,10 @@ static int pm_op(struct device *dev,
 {
 	int error = 0;
 	ktime_t calltime;
+	u64 start;
 
 	calltime = initcall_debug_start(dev);
+	start = suspend_prof_clock();
 
 	switch (state.event) {
 #ifdef CONFIG_SUSPEND
@@ -276,6 +279,7 @@ static int pm_op(struct device *dev,
 		error = -EINVAL;
 	}
 
+	suspend_prof_device(dev, start);
 	initcall_debug_report(dev, calltime, error);
 
 	return error;
@@ -296,6 +300,7 @@ static int pm_noirq_op(struct device *dev,
 {
 	int error = 0;
 	ktime_t calltime = ktime_set(0, 0), delta, rettime;
+	u64 start = suspend_prof_clock();
 
 	if (initcall_debug) {
 		pr_info("calling  %s+ @ %i, parent: %s\n",
@@ -351,6 +356,8 @@ static int pm_noirq_op(struct device *dev,
 		error = -EINVAL;
 	}
 
+	suspend_prof_device(dev, start);
+
 	if (initcall_debug) {
 		rettime = ktime_get();
 		delta = ktime_sub(rettime, calltime);
@@ -494,11 +501,14 @@ static int legacy_resume(struct device *dev, int (*cb)(struct device *dev))
 {
 	int error;
 	ktime_t calltime;
+	u64 start;
 
 	calltime = initcall_debug_start(dev);
+	start = suspend_prof_clock();
 
 	error = cb(dev);
 	suspend_report_result(cb, error);
+	suspend_prof_device(dev, start);
 
 	initcall_debug_report(dev, calltime, error);
 
@@ -854,11 +864,14 @@ static int legacy_suspend(struct device *dev, pm_message_t state,
 {
 	int error;
 	ktime_t calltime;
+	u64 start;
 
 	calltime = initcall_debug_start(dev);
+	start = suspend_prof_clock();
 
 	error = cb(dev, state);
 	suspend_report_result(cb, error);
+	suspend_prof_device(dev, start);
 
 	initcall_debug_report(dev, calltime, error);
 
@@ -0,0 +1,334 @@
+/*
+ * drivers/cpufreq/cpu-boost.c
+ *
+ * Governor independent cpu boost on user input.
+ *
+ * This software is licensed under the terms of the GNU General Public
+ * License version 2, as published by the Free Software Foundation, and
+ * may be copied, distributed, and modified under those terms.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ */
+
+#define pr_fmt(fmt) "cpu-boost: " fmt
+
+#include <linux/kernel.h>
+#include <linux/init.h>
+#include <linux/cpu.h>
+#include <linux/cpufreq.h>
+#include <linux/debugfs.h>
+#include <linux/input.h>
+#include <linux/ktime.h>
+#include <linux/moduleparam.h>
+#include <linux/seq_file.h>
+#include <linux/slab.h>
+#include <linux/spinlock.h>
+#include <linux/workqueue.h>
+
+/*
+ * A touch or key press raises policy->min of every online cpu to
+ * input_boost_freq for input_boost_ms, through a CPUFREQ_ADJUST policy
+ * notifier, so it works the same whatever governor is running.  It also
+ * brings up to input_boost_cpus cores online; taking them down again is
+ * left to whoever manages hotplug.
+ */
+static unsigned int input_boost_freq;
+module_param(input_boost_freq, uint, 0644);
+
+static unsigned int input_boost_ms = 40;
+module_param(input_boost_ms, uint, 0644);
+
+static unsigned int input_boost_cpus = 2;
+module_param(input_boost_cpus, uint, 0644);
+
+/* Input events closer together than this do not restart the boost. */
+static unsigned int min_input_interval_ms = 150;
+module_param(min_input_interval_ms, uint, 0644);
+
+static struct workqueue_struct *cpu_boost_wq;
+static struct work_struct input_boost_work;
+static struct delayed_work input_boost_rem;
+
+/* Boost currently applied to policy->min, 0 when idle. */
+static unsigned int boost_freq;
+
+static DEFINE_SPINLOCK(boost_lock);	/* protects the fields below */
+static u64 last_input_time;
+static u64 pending_input_time;
+static struct {
+	unsigned long events;
+	unsigned long boosts;
+	unsigned long rate_limited;
+	unsigned long cpus_onlined;
+	u64 latency_total;
+	u64 latency_max;
+	u64 latency_last;
+} boost_stats;
+
+static int boost_adjust_notify(struct notifier_block *nb, unsigned long val,
+			       void *data)
+{
+	struct cpufreq_policy *policy = data;
+	unsigned int freq = ACCESS_ONCE(boost_freq);
+
+	if (val != CPUFREQ_ADJUST || !freq)
+		return NOTIFY_OK;
+
+	freq = min(freq, policy->max);
+	if (freq > policy->min) {
+		pr_debug("cpu%u min %u -> %u\n", policy->cpu, policy->min,
+			 freq);
+		cpufreq_verify_within_limits(policy, freq, UINT_MAX);
+	}
+
+	return NOTIFY_OK;
+}
+
+static struct notifier_block boost_adjust_nb = {
+	.notifier_call = boost_adjust_notify,
+};
+
+static void update_policy_online(void)
+{
+	unsigned int cpu;
+
+	get_online_cpus();
+	for_each_online_cpu(cpu)
+		cpufreq_update_policy(cpu);
+	put_online_cpus();
+}
+
+#ifdef CONFIG_SMP
+static unsigned int boost_online_cpus(void)
+{
+	unsigned int cpu, onlined = 0;
+
+	for_each_present_cpu(cpu) {
+		if (num_online_cpus() >= input_boost_cpus)
+			break;
+		if (cpu_online(cpu))
+			continue;
+		if (!cpu_up(cpu))
+			onlined++;
+	}
+
+	return onlined;
+}
+#else
+static inline unsigned int boost_online_cpus(void)
+{
+	return 0;
+}
+#endif
+
+/* CLOCK_MONOTONIC in microseconds */
+static u64 boost_time_us(void)
+{
+	struct timespec ts;
+
+	ktime_get_ts(&ts);
+	return (u64)ts.tv_sec * USEC_PER_SEC + ts.tv_nsec / NSEC_PER_USEC;
+}
+
+static void do_input_boost_rem(struct work_struct *work)
+{
+	boost_freq = 0;
+	update_policy_online();
+}
+
+static void do_input_boost(struct work_struct *work)
+{
+	unsigned long flags;
+	unsigned int onlined;
+	u64 start, latency;
+
+	cancel_delayed_work_sync(&input_boost_rem);
+
+	onlined = boost_online_cpus();
+	boost_freq = input_boost_freq;
+	update_policy_online();
+
+	spin_lock_irqsave(&boost_lock, flags);
+	start = pending_input_time;
+	pending_input_time = 0;
+	latency = boost_time_us() - start;
+	boost_stats.boosts++;
+	boost_stats.cpus_onlined += onlined;
+	boost_stats.latency_total += latency;
+	boost_stats.latency_last = latency;
+	if (latency > boost_stats.latency_max)
+		boost_stats.latency_max = latency;
+	spin_unlock_irqrestore(&boost_lock, flags);
+
+	queue_delayed_work(cpu_boost_wq, &input_boost_rem,
+			   msecs_to_jiffies(input_boost_ms));
+}
+
+static void cpuboost_input_event(struct input_handle *handle,
+		unsigned int type, unsigned int code, int value)
+{
+	unsigned long flags;
+	u64 now;
+
+	if (!input_boost_freq)
+		return;
+
+	now = boost_time_us();
+
+	spin_lock_irqsave(&boost_lock, flags);
+	boost_stats.events++;
+	if (pending_input_time ||
+	    now - last_input_time < min_input_interval_ms * USEC_PER_MSEC) {
+		boost_stats.rate_limited++;
+		spin_unlock_irqrestore(&boost_lock, flags);
+		return;
+	}
+	last_input_time = now;
+	pending_input_time = now;
+	spin_unlock_irqrestore(&boost_lock, flags);
+
+	queue_work(cpu_boost_wq, &input_boost_work);
+}
+
+static int cpuboost_input_connect(struct input_handler *handler,
+		struct input_dev *dev, const struct input_device_id *id)
+{
+	struct input_handle *handle;
+	int error;
+
+	handle = kzalloc(sizeof(struct input_handle), GFP_KERNEL);
+	if (!handle)
+		return -ENOMEM;
+
+	handle->dev = dev;
+	handle->handler = handler;
+	handle->name = "cpu-boost";
+
+	error = input_register_handle(handle);
+	if (error)
+		goto err2;
+
+	error = input_open_device(handle);
+	if (error)
+		goto err1;
+
+	return 0;
+err1:
+	input_unregister_handle(handle);
+err2:
+	kfree(handle);
+	return error;
+}
+
+static void cpuboost_input_disconnect(struct input_handle *handle)
+{
+	input_close_device(handle);
+	input_unregister_handle(handle);
+	kfree(handle);
+}
+
+static const struct input_device_id cpuboost_ids[] = {
+	/* multi-touch touchscreen */
+	{
+		.flags = INPUT_DEVICE_ID_MATCH_EVBIT |
+			INPUT_DEVICE_ID_MATCH_ABSBIT,
+		.evbit = { BIT_MASK(EV_ABS) },
+		.absbit = { [BIT_WORD(ABS_MT_POSITION_X)] =
+			BIT_MASK(ABS_MT_POSITION_X) |
+			BIT_MASK(ABS_MT_POSITION_Y) },
+	},
+	/* touchpad */
+	{
+		.flags = INPUT_DEVICE_ID_MATCH_KEYBIT |
+			INPUT_DEVICE_ID_MATCH_ABSBIT,
+		.keybit = { [BIT_WORD(BTN_TOUCH)] = BIT_MASK(BTN_TOUCH) },
+		.absbit = { [BIT_WORD(ABS_X)] =
+			BIT_MASK(ABS_X) | BIT_MASK(ABS_Y) },
+	},
+	/* keypad */
+	{
+		.flags = INPUT_DEVICE_ID_MATCH_EVBIT,
+		.evbit = { BIT_MASK(EV_KEY) },
+	},
+	{ },
+};
+
+static struct input_handler cpuboost_input_handler = {
+	.event		= cpuboost_input_event,
+	.connect	= cpuboost_input_connect,
+	.disconnect	= cpuboost_input_disconnect,
+	.name		= "cpu-boost",
+	.id_table	= cpuboost_ids,
+};
+
+#ifdef CONFIG_DEBUG_FS
+static int cpu_boost_stats_show(struct seq_file *m, void *unused)
+{
+	unsigned long flags, boosts;
+	u64 avg;
+
+	spin_lock_irqsave(&boost_lock, flags);
+	boosts = boost_stats.boosts;
+	avg = boost_stats.latency_total;
+	if (boosts)
+		do_div(avg, boosts);
+
+	seq_printf(m, "events:          %lu\n", boost_stats.events);
+	seq_printf(m, "boosts:          %lu\n", boosts);
+	seq_printf(m, "rate_limited:    %lu\n", boost_stats.rate_limited);
+	seq_printf(m, "cpus_onlined:    %lu\n", boost_stats.cpus_onlined);
+	seq_printf(m, "latency_avg_us:  %llu\n", avg);
+	seq_printf(m, "latency_max_us:  %llu\n", boost_stats.latency_max);
+	seq_printf(m, "latency_last_us: %llu\n", boost_stats.latency_last);
+	spin_unlock_irqrestore(&boost_lock, flags);
+
+	seq_printf(m, "active_freq:     %u\n", ACCESS_ONCE(boost_freq));
+	return 0;
+}
+
+static int cpu_boost_stats_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, cpu_boost_stats_show, NULL);
+}
+
+static const struct file_operations cpu_boost_stats_fops = {
+	.open		= cpu_boost_stats_open,
+	.read		= seq_read,
+	.llseek		= seq_lseek,
+	.release	= single_release,
+};
+
+static void cpu_boost_debugfs_init(void)
+{
+	debugfs_create_file("cpu_boost", S_IRUGO, NULL, NULL,
+			    &cpu_boost_stats_fops);
+}
+#else
+static inline void cpu_boost_debugfs_init(void) {}
+#endif
+
+static int __init cpu_boost_init(void)
+{
+	int ret;
+
+	cpu_boost_wq = alloc_workqueue("cpuboost_wq", WQ_HIGHPRI, 0);
+	if (!cpu_boost_wq)
+		return -ENOMEM;
+
+	INIT_WORK(&input_boost_work, do_input_boost);
+	INIT_DELAYED_WORK(&input_boost_rem, do_input_boost_rem);
+
+	cpufreq_register_notifier(&boost_adjust_nb, CPUFREQ_POLICY_NOTIFIER);
+
+	ret = input_register_handler(&cpuboost_input_handler);
+	if (ret)
+		pr_err("failed to register input handler: %d\n", ret);
+
+	cpu_boost_debugfs_init();
+	return 0;
+}
+late_initcall(cpu_boost_init);
@@ -116,6 +116,14 @@ static int timer_slack_val = DEFAULT_TIMER_SLACK;
 
 static bool io_is_busy;
 
+/*
+ * Ramp the destination cpu straight away when the scheduler moves at least
+ * this much load (percent of the source cpu at its current speed) onto it,
+ * instead of waiting for the next timer sample.  0 disables.
+ */
+#define DEFAULT_MIGRATION_BOOST_LOAD 20
+static unsigned long migration_boost_load = DEFAULT_MIGRATION_BOOST_LOAD;
+
 static int cpufreq_governor_interactive(struct cpufreq_policy *policy,
 		unsigned int event);
 
@@ -640,6 +648,71 @@ static struct notifier_block cpufreq_notifier_block = {
 	.notifier_call = cpufreq_interactive_notifier,
 };
 
+static int cpufreq_interactive_migration_notifier(
+	struct notifier_block *nb, unsigned long val, void *data)
+{
+	struct sched_migration_data *mig = data;
+	struct cpufreq_interactive_cpuinfo *pcpu =
+		&per_cpu(cpuinfo, mig->dest_cpu);
+	unsigned int src_freq, new_freq;
+	unsigned long load, flags;
+	u64 now;
+
+	load = (mig->load * 100) >> SCHED_LOAD_TRACK_SHIFT;
+	if (!migration_boost_load || load < migration_boost_load)
+		return 0;
+
+	if (!down_read_trylock(&pcpu->enable_sem))
+		return 0;
+	if (!pcpu->governor_enabled)
+		goto exit;
+
+	/* Both cpus already run at the same speed. */
+	if (cpumask_test_cpu(mig->src_cpu, pcpu->policy->cpus))
+		goto exit;
+
+	/*
+	 * The load was measured while running at the source cpu's speed,
+	 * scale it the same way the timer does for its own samples.
+	 */
+	src_freq = ACCESS_ONCE(per_cpu(cpuinfo, mig->src_cpu).target_freq);
+	if (!src_freq)
+		src_freq = pcpu->policy->cur;
+
+	new_freq = choose_freq(pcpu, load * src_freq);
+	if (load >= go_hispeed_load && new_freq < hispeed_freq)
+		new_freq = hispeed_freq;
+
+	/* Anything above hispeed_freq still waits for above_hispeed_delay. */
+	if (pcpu->target_freq < hispeed_freq && new_freq > hispeed_freq)
+		new_freq = hispeed_freq;
+
+	if (new_freq <= pcpu->target_freq)
+		goto exit;
+
+	trace_cpufreq_interactive_target(mig->dest_cpu, load,
+					 pcpu->target_freq, pcpu->policy->cur,
+					 new_freq);
+
+	now = ktime_to_us(ktime_get());
+	spin_lock_irqsave(&speedchange_cpumask_lock, flags);
+	pcpu->target_freq = new_freq;
+	pcpu->floor_freq = new_freq;
+	pcpu->floor_validate_time = now;
+	pcpu->hispeed_validate_time = now;
+	cpumask_set_cpu(mig->dest_cpu, &speedchange_cpumask);
+	spin_unlock_irqrestore(&speedchange_cpumask_lock, flags);
+	wake_up_process(speedchange_task);
+
+exit:
+	up_read(&pcpu->enable_sem);
+	return 0;
+}
+
+static struct notifier_block cpufreq_interactive_migration_nb = {
+	.notifier_call = cpufreq_interactive_migration_notifier,
+};
+
 static unsigned int *get_tokenized_data(const char *buf, int *num_tokens)
 {
 	const char *cp;
@@ -979,6 +1052,29 @@ static ssize_t store_io_is_busy(struct kobject *kobj,
 static struct global_attr io_is_busy_attr = __ATTR(io_is_busy, 0644,
 		show_io_is_busy, store_io_is_busy);
 
+static ssize_t show_migration_boost_load(struct kobject *kobj,
+			struct attribute *attr, char *buf)
+{
+	return sprintf(buf, "%lu\n", migration_boost_load);
+}
+
+static ssize_t store_migration_boost_load(struct kobject *kobj,
+			struct attribute *attr, const char *buf, size_t count)
+{
+	int ret;
+	unsigned long val;
+
+	ret = kstrtoul(buf, 0, &val);
+	if (ret < 0)
+		return ret;
+	migration_boost_load = val;
+	return count;
+}
+
+static struct global_attr migration_boost_load_attr =
+	__ATTR(migration_boost_load, 0644,
+	       show_migration_boost_load, store_migration_boost_load);
+
 static struct attribute *interactive_attributes[] = {
 	&target_loads_attr.attr,
 	&above_hispeed_delay_attr.attr,
@@ -991,6 +1087,7 @@ static struct attribute *interactive_attributes[] = {
 	&boostpulse.attr,
 	&boostpulse_duration.attr,
 	&io_is_busy_attr.attr,
+	&migration_boost_load_attr.attr,
 	NULL,
 };
 
@@ -1083,6 +1180,8 @@ static int cpufreq_governor_interactive(struct cpufreq_policy *policy,
 		idle_notifier_register(&cpufreq_interactive_idle_nb);
 		cpufreq_register_notifier(
 			&cpufreq_notifier_block, CPUFREQ_TRANSITION_NOTIFIER);
+		register_sched_migration_notifier(
+			&cpufreq_interactive_migration_nb);
 		mutex_unlock(&gov_lock);
 		break;
 
@@ -1102,6 +1201,8 @@ static int cpufreq_governor_interactive(struct cpufreq_policy *policy,
 			return 0;
 		}
 
+		unregister_sched_migration_notifier(
+			&cpufreq_interactive_migration_nb);
 		cpufreq_unregister_notifier(
 			&cpufreq_notifier_block, CPUFREQ_TRANSITION_NOTIFIER);
 		idle_notifier_unregister(&cpufreq_interactive_idle_nb);
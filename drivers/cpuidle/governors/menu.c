@@ -226,6 +226,7 @@ static int menu_select(struct cpuidle_device *dev)
 	int i;
 	int multiplier;
 	struct timespec t;
+	u64 tick_pred_us;
 
 	if (data->needs_update) {
 		menu_update(dev);
@@ -262,6 +263,15 @@ static int menu_select(struct cpuidle_device *dev)
 
 	detect_repeating_patterns(data);
 
+	/*
+	 * The tick code sees every idle period, including the ones that are
+	 * too short to come through here, so trust it when it expects an
+	 * earlier wakeup.
+	 */
+	tick_pred_us = ktime_to_us(tick_nohz_get_predicted_length());
+	if (tick_pred_us && tick_pred_us < data->predicted_us)
+		data->predicted_us = tick_pred_us;
+
 	/*
 	 * We want to default to C1 (hlt), not to busy polling
 	 * unless the timer is happening really really soon.
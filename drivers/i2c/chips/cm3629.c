@@ -2252,6 +2252,7 @@ static int cm3629_probe(struct i2c_client *client,
 			EARLY_SUSPEND_LEVEL_BLANK_SCREEN + 1;
 	lpi->early_suspend.suspend = cm3629_early_suspend;
 	lpi->early_suspend.resume = cm3629_late_resume;
+	lpi->early_suspend.flags = EARLY_SUSPEND_ASYNC;
 	register_early_suspend(&lpi->early_suspend);
 
 	D("[PS][cm3629] %s: Probe success!\n", __func__);
@@ -370,6 +370,7 @@ static int tps61310_probe(struct i2c_client *client,
 #ifdef CONFIG_HAS_EARLYSUSPEND
 	tps61310->fl_early_suspend.suspend = flashlight_early_suspend;
 	tps61310->fl_early_suspend.resume  = flashlight_late_resume;
+	tps61310->fl_early_suspend.flags   = EARLY_SUSPEND_ASYNC;
 	register_early_suspend(&tps61310->fl_early_suspend);
 #endif
 	this_tps61310 = tps61310;
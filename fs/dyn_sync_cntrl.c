@@ -119,6 +119,7 @@ static struct early_suspend dyn_fsync_early_suspend_handler =
 		.level = EARLY_SUSPEND_LEVEL_BLANK_SCREEN,
 		.suspend = dyn_fsync_early_suspend,
 		.resume = dyn_fsync_late_resume,
+		.flags = EARLY_SUSPEND_ASYNC,
 	};
 
 static int dyn_fsync_init(void)
@@ -18,6 +18,7 @@
 
 #ifdef CONFIG_HAS_EARLYSUSPEND
 #include <linux/list.h>
+#include <linux/workqueue.h>
 #endif
 
 /* The early_suspend structure defines suspend and resume hooks to be called
@@ -29,18 +30,32 @@
  * the suspend handlers have already been called without a matching call to the
  * resume handlers, the suspend handler will be called directly from
  * register_early_suspend. This direct call can violate the normal level order.
+ *
+ * Handlers that set EARLY_SUSPEND_ASYNC in flags do not depend on the order
+ * of any other handler. They are run concurrently on a worker pool: on suspend
+ * alongside the ordered handlers, and on resume only after all ordered
+ * handlers, including the display ones, have returned. The early suspend path
+ * waits for any async resume still in flight before suspending again.
  */
 enum {
 	EARLY_SUSPEND_LEVEL_BLANK_SCREEN = 50,
 	EARLY_SUSPEND_LEVEL_STOP_DRAWING = 100,
 	EARLY_SUSPEND_LEVEL_DISABLE_FB = 150,
 };
+enum {
+	EARLY_SUSPEND_ASYNC = 1U << 0,
+};
 struct early_suspend {
 #ifdef CONFIG_HAS_EARLYSUSPEND
 	struct list_head link;
 	int level;
+	unsigned int flags;
 	void (*suspend)(struct early_suspend *h);
 	void (*resume)(struct early_suspend *h);
+	struct work_struct suspend_work;
+	struct work_struct resume_work;
+	u64 suspend_ns;
+	u64 resume_ns;
 #endif
 };
 
@@ -923,6 +923,8 @@ struct file_ra_state {
 
 	unsigned int ra_pages;		/* Maximum readahead window */
 	unsigned int mmap_miss;		/* Cache miss stat for mmap accesses */
+	unsigned int stride;		/* Last gap between missing reads */
+	unsigned int random_reads;	/* Recent reads that were random */
 	loff_t prev_pos;		/* Cache last read() position */
 };
 
@@ -0,0 +1,42 @@
+/* include/linux/lock_cstat.h
+ *
+ * Lightweight contention statistics for sleeping locks.
+ *
+ * This software is licensed under the terms of the GNU General Public
+ * License version 2, as published by the Free Software Foundation, and
+ * may be copied, distributed, and modified under those terms.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ */
+
+#ifndef _LINUX_LOCK_CSTAT_H
+#define _LINUX_LOCK_CSTAT_H
+
+#include <linux/types.h>
+
+/*
+ * Unlike CONFIG_LOCK_STAT these are not per lock class, just per lock
+ * type, which is cheap enough to leave on in a production kernel.
+ */
+enum lock_cstat_type {
+	LOCK_CSTAT_MUTEX,
+	LOCK_CSTAT_RWSEM_READ,
+	LOCK_CSTAT_RWSEM_WRITE,
+	LOCK_CSTAT_NR,
+};
+
+#ifdef CONFIG_LOCK_CONTENTION_STATS
+extern u64 lock_cstat_clock(void);
+extern void lock_cstat_account(enum lock_cstat_type type, bool spun,
+			       u64 start);
+#else
+static inline u64 lock_cstat_clock(void) { return 0; }
+static inline void lock_cstat_account(enum lock_cstat_type type, bool spun,
+				      u64 start) {}
+#endif
+
+#endif
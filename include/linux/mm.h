@@ -40,6 +40,10 @@ extern int sysctl_legacy_va_layout;
 #define sysctl_legacy_va_layout 0
 #endif
 
+#ifdef CONFIG_ANON_LARGE_PAGES
+extern int sysctl_anon_large_pages;
+#endif
+
 #include <asm/page.h>
 #include <asm/pgtable.h>
 #include <asm/processor.h>
@@ -106,7 +110,7 @@ extern unsigned int kobjsize(const void *objp);
 #define VM_NORESERVE	0x00200000	/* should the VM suppress accounting */
 #define VM_HUGETLB	0x00400000	/* Huge TLB Page VM */
 #define VM_NONLINEAR	0x00800000	/* Is non-linear (remap_file_pages) */
-#ifndef CONFIG_TRANSPARENT_HUGEPAGE
+#if !defined(CONFIG_TRANSPARENT_HUGEPAGE) && !defined(CONFIG_ANON_LARGE_PAGES)
 #define VM_MAPPED_COPY	0x01000000	/* T if mapped copy of data (nommu mmap) */
 #else
 #define VM_HUGEPAGE	0x01000000	/* MADV_HUGEPAGE marked this vma */
@@ -108,6 +108,9 @@ enum zone_stat_item {
 	NR_SHMEM,		/* shmem pages (included tmpfs/GEM pages) */
 	NR_DIRTIED,		/* page dirtyings since bootup */
 	NR_WRITTEN,		/* page writings since bootup */
+	WORKINGSET_REFAULT,	/* evicted file pages faulted back in */
+	WORKINGSET_ACTIVATE,	/* refaults activated as working set */
+	NR_PREZERO,		/* zeroed pages waiting for anon faults */
 #ifdef CONFIG_NUMA
 	NUMA_HIT,		/* allocated in intended node */
 	NUMA_MISS,		/* allocated in non intended node */
@@ -196,6 +199,13 @@ struct per_cpu_pages {
 	struct list_head lists[MIGRATE_PCPTYPES];
 };
 
+/*
+ * Blocks of order 1 to PCP_MAX_ORDER are cached per cpu as well, each order
+ * on its own lists and with its own high and batch marks, counted in blocks
+ * of that order rather than in pages.
+ */
+#define PCP_MAX_ORDER		PAGE_ALLOC_COSTLY_ORDER
+
 struct per_cpu_pageset {
 	struct per_cpu_pages pcp;
 #ifdef CONFIG_NUMA
@@ -205,7 +215,18 @@ struct per_cpu_pageset {
 	s8 stat_threshold;
 	s8 vm_stat_diff[NR_VM_ZONE_STAT_ITEMS];
 #endif
+	struct per_cpu_pages pcp_high[PCP_MAX_ORDER];	/* order - 1 */
+};
+
+#ifdef CONFIG_ZONE_LOCK_STATS
+/* zone->lock hold times in the page allocator, updated under the lock */
+struct zone_lock_stat {
+	u64			acquired;	/* local_clock() at lock */
+	unsigned long		nr;
+	u64			hold_total;	/* in ns */
+	u64			hold_max;
 };
+#endif
 
 #endif /* !__GENERATING_BOUNDS.H */
 
@@ -329,6 +350,9 @@ struct zone {
 	 * free areas of different sizes
 	 */
 	spinlock_t		lock;
+#ifdef CONFIG_ZONE_LOCK_STATS
+	struct zone_lock_stat	lock_stat;
+#endif
 	int                     all_unreclaimable; /* All pages pinned */
 #ifdef CONFIG_MEMORY_HOTPLUG
 	/* see spanned/present_pages for more description */
@@ -376,6 +400,8 @@ struct zone {
 	 */
 	unsigned int inactive_ratio;
 
+	/* Inactive file evictions + activations, see mm/workingset.c */
+	atomic_long_t		inactive_age;
 
 	ZONE_PADDING(_pad2_)
 	/* Rarely used or read-mostly fields */
@@ -661,6 +687,17 @@ typedef struct pglist_data {
 	int kswapd_max_order;
 	struct timer_list watermark_timer;
 	enum zone_type classzone_idx;
+#ifdef CONFIG_COMPACTION
+	int kcompactd_max_order;
+	enum zone_type kcompactd_classzone_idx;
+	wait_queue_head_t kcompactd_wait;
+	struct task_struct *kcompactd;	/* lock_memory_hotplug() */
+#endif
+#ifdef CONFIG_PREZERO_PAGES
+	spinlock_t prezero_lock;
+	struct list_head prezero_list;
+	unsigned long nr_prezero;	/* pages on prezero_list */
+#endif
 } pg_data_t;
 
 #define node_present_pages(nid)	(NODE_DATA(nid)->node_present_pages)
@@ -0,0 +1,20 @@
+#ifndef _LINUX_PREZERO_H
+#define _LINUX_PREZERO_H
+
+struct ctl_table;
+struct vm_area_struct;
+struct page;
+
+#ifdef CONFIG_PREZERO_PAGES
+extern int sysctl_prezero_pages;
+extern int prezero_sysctl_handler(struct ctl_table *table, int write,
+			void __user *buffer, size_t *length, loff_t *ppos);
+extern struct page *alloc_prezeroed_page(struct vm_area_struct *vma);
+#else
+static inline struct page *alloc_prezeroed_page(struct vm_area_struct *vma)
+{
+	return NULL;
+}
+#endif /* CONFIG_PREZERO_PAGES */
+
+#endif /* _LINUX_PREZERO_H */
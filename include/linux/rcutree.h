@@ -60,6 +60,8 @@ static inline void exit_rcu(void)
 extern void synchronize_rcu_bh(void);
 extern void synchronize_sched_expedited(void);
 extern void synchronize_rcu_expedited(void);
+extern unsigned long get_state_synchronize_rcu(void);
+extern void cond_synchronize_rcu(unsigned long oldstate);
 
 static inline void synchronize_rcu_bh_expedited(void)
 {
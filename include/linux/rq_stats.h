@@ -16,7 +16,6 @@ struct rq_data {
 	unsigned long rq_poll_jiffies;
 	unsigned long def_timer_jiffies;
 	unsigned long rq_poll_last_jiffy;
-	unsigned long rq_poll_total_jiffies;
 	unsigned long def_timer_last_jiffy;
 	unsigned int def_interval;
 	int64_t def_start_time;
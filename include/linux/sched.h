@@ -144,6 +144,36 @@ extern unsigned long nr_iowait(void);
 extern unsigned long nr_iowait_cpu(int cpu);
 extern unsigned long this_cpu_load(void);
 
+/* Decayed per-cpu utilization and nr_running, see kernel/sched.c */
+#define SCHED_LOAD_TRACK_SHIFT	10
+#define SCHED_LOAD_TRACK_SCALE	(1UL << SCHED_LOAD_TRACK_SHIFT)
+extern unsigned long sched_cpu_util(int cpu);
+extern unsigned long sched_cpu_nr_running_avg(int cpu);
+extern unsigned long sched_nr_running_avg(void);
+
+/*
+ * Migration notifiers are called after a wakeup or a load balance pass
+ * moved tasks from @src_cpu to @dest_cpu.  @load is the summed decayed
+ * utilization of the moved tasks, in SCHED_LOAD_TRACK_SCALE units.  The
+ * chain is atomic and runs with no runqueue lock held.
+ */
+struct sched_migration_data {
+	int src_cpu;
+	int dest_cpu;
+	unsigned long load;
+	bool wakeup;
+};
+
+struct notifier_block;
+extern int register_sched_migration_notifier(struct notifier_block *nb);
+extern int unregister_sched_migration_notifier(struct notifier_block *nb);
+
+#ifdef CONFIG_SMP
+extern void sched_idle_set_state(unsigned int exit_latency);
+#else
+static inline void sched_idle_set_state(unsigned int exit_latency) { }
+#endif
+
 
 extern void calc_global_load(unsigned long ticks);
 
@@ -360,6 +390,8 @@ extern signed long schedule_timeout_killable(signed long timeout);
 extern signed long schedule_timeout_uninterruptible(signed long timeout);
 asmlinkage void schedule(void);
 extern int mutex_spin_on_owner(struct mutex *lock, struct task_struct *owner);
+extern int rwsem_spin_on_owner(struct rw_semaphore *sem,
+			       struct task_struct *owner);
 
 struct nsproxy;
 struct user_namespace;
@@ -740,6 +772,7 @@ struct sched_info {
 	/* timestamps */
 	unsigned long long last_arrival,/* when we last ran on a cpu */
 			   last_queued;	/* when we were last queued to run */
+	int queued_preempt;		/* last_queued is from a preemption */
 };
 #endif /* defined(CONFIG_SCHEDSTATS) || defined(CONFIG_TASK_DELAY_ACCT) */
 
@@ -1163,6 +1196,11 @@ struct sched_statistics {
 	u64			nr_wakeups_affine_attempts;
 	u64			nr_wakeups_passive;
 	u64			nr_wakeups_idle;
+
+	/* wakeup-to-run latency */
+	u64			wakeup_latency_max;
+	u64			wakeup_latency_sum;
+	u64			wakeup_latency_count;
 };
 #endif
 
@@ -1179,6 +1217,13 @@ struct sched_entity {
 
 	u64			nr_migrations;
 
+#ifdef CONFIG_SMP
+	/* decayed utilization, carried along on migration */
+	u64			lt_stamp;
+	u64			lt_exec;
+	unsigned long		lt_util;
+#endif
+
 #ifdef CONFIG_SCHEDSTATS
 	struct sched_statistics statistics;
 #endif
@@ -2025,6 +2070,7 @@ extern unsigned int sysctl_sched_nr_migrate;
 extern unsigned int sysctl_sched_time_avg;
 extern unsigned int sysctl_timer_migration;
 extern unsigned int sysctl_sched_shares_window;
+extern unsigned int sysctl_sched_packing_util;
 
 int sched_proc_update_handler(struct ctl_table *table, int write,
 		void __user *buffer, size_t *length,
@@ -2048,6 +2094,10 @@ int sched_rt_handler(struct ctl_table *table, int write,
 		void __user *buffer, size_t *lenp,
 		loff_t *ppos);
 
+#ifdef CONFIG_CFS_BANDWIDTH
+extern unsigned int sysctl_sched_cfs_bandwidth_slice;
+#endif
+
 #ifdef CONFIG_SCHED_AUTOGROUP
 extern unsigned int sysctl_sched_autogroup_enabled;
 
@@ -0,0 +1,70 @@
+/* include/linux/suspend_profile.h
+ *
+ * Suspend/resume latency profiler.
+ *
+ * This software is licensed under the terms of the GNU General Public
+ * License version 2, as published by the Free Software Foundation, and
+ * may be copied, distributed, and modified under those terms.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ */
+
+#ifndef _LINUX_SUSPEND_PROFILE_H
+#define _LINUX_SUSPEND_PROFILE_H
+
+#include <linux/types.h>
+
+struct device;
+
+/*
+ * A profiled cycle is one pass through early_suspend(), late_resume() or
+ * enter_state().  Each cycle is split into the stages below; a stage that
+ * is not part of a given cycle simply has no sample in it.
+ */
+enum suspend_prof_cycle {
+	SUSPEND_PROF_CYCLE_EARLY_SUSPEND,
+	SUSPEND_PROF_CYCLE_SUSPEND,
+	SUSPEND_PROF_CYCLE_LATE_RESUME,
+	SUSPEND_PROF_CYCLE_NR,
+};
+
+enum suspend_prof_stage {
+	SUSPEND_PROF_EARLY_SUSPEND,
+	SUSPEND_PROF_FREEZE,
+	SUSPEND_PROF_DPM_SUSPEND,
+	SUSPEND_PROF_DPM_SUSPEND_NOIRQ,
+	SUSPEND_PROF_SYSCORE_SUSPEND,
+	SUSPEND_PROF_PLATFORM,		/* whole ->enter(), includes sleep */
+	SUSPEND_PROF_PLATFORM_ENTER,	/* ->enter() until power collapse */
+	SUSPEND_PROF_PLATFORM_EXIT,	/* wakeup until ->enter() returns */
+	SUSPEND_PROF_SYSCORE_RESUME,
+	SUSPEND_PROF_DPM_RESUME_NOIRQ,
+	SUSPEND_PROF_DPM_RESUME,
+	SUSPEND_PROF_THAW,
+	SUSPEND_PROF_LATE_RESUME,
+	SUSPEND_PROF_NR_STAGES,
+};
+
+#ifdef CONFIG_PM_SUSPEND_PROFILE
+extern u64 suspend_prof_clock(void);
+extern void suspend_prof_cycle_begin(enum suspend_prof_cycle kind);
+extern void suspend_prof_cycle_end(int error);
+extern void suspend_prof_stage_begin(enum suspend_prof_stage stage);
+extern void suspend_prof_stage_end(enum suspend_prof_stage stage);
+extern void suspend_prof_handler(void *fn, u64 start);
+extern void suspend_prof_device(struct device *dev, u64 start);
+#else
+static inline u64 suspend_prof_clock(void) { return 0; }
+static inline void suspend_prof_cycle_begin(enum suspend_prof_cycle kind) {}
+static inline void suspend_prof_cycle_end(int error) {}
+static inline void suspend_prof_stage_begin(enum suspend_prof_stage stage) {}
+static inline void suspend_prof_stage_end(enum suspend_prof_stage stage) {}
+static inline void suspend_prof_handler(void *fn, u64 start) {}
+static inline void suspend_prof_device(struct device *dev, u64 start) {}
+#endif
+
+#endif
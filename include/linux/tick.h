@@ -26,6 +26,9 @@ enum tick_nohz_mode {
 	NOHZ_MODE_HIGHRES,
 };
 
+/* Number of past idle periods the idle length prediction looks at */
+#define TICK_IDLE_INTERVALS	8
+
 /**
  * struct tick_sched - sched tick emulation and no idle tick control/stats
  * @sched_timer:	hrtimer to schedule the periodic tick in high
@@ -45,6 +48,16 @@ enum tick_nohz_mode {
  * @iowait_sleeptime:	Sum of the time slept in idle with sched tick stopped, with IO outstanding
  * @sleep_length:	Duration of the current idle sleep
  * @do_timer_lst:	CPU was the last one doing do_timer before going idle
+ * @idle_pred_entry:	Start of the idle period being measured for prediction
+ * @idle_intervals:	Lengths (usecs) of the last idle periods
+ * @idle_interval_ptr:	Next slot in @idle_intervals
+ * @idle_predicted:	Predicted length (nsecs) of this idle period, 0 if none
+ * @idle_tick_kept:	The tick was kept running because of the prediction
+ * @idle_pred_hits:	Idle periods within a factor of 2 of the prediction
+ * @idle_pred_misses:	Idle periods outside a factor of 2 of the prediction
+ * @idle_tick_keeps:	Number of times the tick was kept for a short idle
+ * @idle_keep_misses:	Tick kept, but nothing but the tick ended the idle
+ * @idle_short_stops:	Tick stopped, but the idle ended within a tick
  */
 struct tick_sched {
 	struct hrtimer			sched_timer;
@@ -67,6 +80,16 @@ struct tick_sched {
 	unsigned long			next_jiffies;
 	ktime_t				idle_expires;
 	int				do_timer_last;
+	ktime_t				idle_pred_entry;
+	u32				idle_intervals[TICK_IDLE_INTERVALS];
+	int				idle_interval_ptr;
+	s64				idle_predicted;
+	int				idle_tick_kept;
+	unsigned long			idle_pred_hits;
+	unsigned long			idle_pred_misses;
+	unsigned long			idle_tick_keeps;
+	unsigned long			idle_keep_misses;
+	unsigned long			idle_short_stops;
 };
 
 extern void __init tick_init(void);
@@ -124,6 +147,7 @@ static inline int tick_oneshot_mode_active(void) { return 0; }
 extern void tick_nohz_stop_sched_tick(int inidle);
 extern void tick_nohz_restart_sched_tick(void);
 extern ktime_t tick_nohz_get_sleep_length(void);
+extern ktime_t tick_nohz_get_predicted_length(void);
 extern u64 get_cpu_idle_time_us(int cpu, u64 *last_update_time);
 extern u64 get_cpu_iowait_time_us(int cpu, u64 *last_update_time);
 # else
@@ -135,6 +159,12 @@ static inline ktime_t tick_nohz_get_sleep_length(void)
 
 	return len;
 }
+static inline ktime_t tick_nohz_get_predicted_length(void)
+{
+	ktime_t len = { .tv64 = 0 };
+
+	return len;
+}
 static inline u64 get_cpu_idle_time_us(int cpu, u64 *unused) { return -1; }
 static inline u64 get_cpu_iowait_time_us(int cpu, u64 *unused) { return -1; }
 # endif /* !NO_HZ */
@@ -36,6 +36,7 @@ enum vm_event_item { PGPGIN, PGPGOUT, PSWPIN, PSWPOUT,
 		KSWAPD_LOW_WMARK_HIT_QUICKLY, KSWAPD_HIGH_WMARK_HIT_QUICKLY,
 		KSWAPD_SKIP_CONGESTION_WAIT,
 		PAGEOUTRUN, ALLOCSTALL, PGROTATED,
+		SWAP_RA, SWAP_RA_HIT, SWAP_RA_MISS,
 #ifdef CONFIG_COMPACTION
 		COMPACTBLOCKS, COMPACTPAGES, COMPACTPAGEFAILED,
 		COMPACTSTALL, COMPACTFAIL, COMPACTSUCCESS,
@@ -57,6 +58,17 @@ enum vm_event_item { PGPGIN, PGPGOUT, PSWPIN, PSWPOUT,
 		THP_COLLAPSE_ALLOC,
 		THP_COLLAPSE_ALLOC_FAILED,
 		THP_SPLIT,
+#endif
+#ifdef CONFIG_ANON_LARGE_PAGES
+		ANON_LARGE_ALLOC,
+		ANON_LARGE_FALLBACK,
+		ANON_LARGE_FOLD,
+		ANON_LARGE_SPLIT,
+#endif
+#ifdef CONFIG_PREZERO_PAGES
+		PREZERO_FILL,
+		PREZERO_HIT,
+		PREZERO_MISS,
 #endif
 		NR_VM_EVENT_ITEMS
 };
@@ -65,6 +65,48 @@ TRACE_EVENT(machine_suspend,
 	TP_printk("state=%lu", (unsigned long)__entry->state)
 );
 
+TRACE_EVENT(suspend_resume_stage,
+
+	TP_PROTO(const char *stage, bool start),
+
+	TP_ARGS(stage, start),
+
+	TP_STRUCT__entry(
+		__string(	stage,		stage		)
+		__field(	bool,		start		)
+	),
+
+	TP_fast_assign(
+		__assign_str(stage, stage);
+		__entry->start = start;
+	),
+
+	TP_printk("%s %s", __get_str(stage),
+		  __entry->start ? "begin" : "end")
+);
+
+TRACE_EVENT(suspend_resume_callback,
+
+	TP_PROTO(const char *name, const char *stage, u64 delta_ns),
+
+	TP_ARGS(name, stage, delta_ns),
+
+	TP_STRUCT__entry(
+		__string(	name,		name		)
+		__string(	stage,		stage		)
+		__field(	u64,		delta_ns	)
+	),
+
+	TP_fast_assign(
+		__assign_str(name, name);
+		__assign_str(stage, stage);
+		__entry->delta_ns = delta_ns;
+	),
+
+	TP_printk("%s stage=%s delta_ns=%llu", __get_str(name),
+		  __get_str(stage), (unsigned long long)__entry->delta_ns)
+);
+
 /* This code will be removed after deprecation time exceeded (2.6.41) */
 #ifdef CONFIG_EVENT_POWER_TRACING_DEPRECATED
 
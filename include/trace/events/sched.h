@@ -329,6 +329,20 @@ DEFINE_EVENT(sched_stat_template, sched_stat_iowait,
 	     TP_PROTO(struct task_struct *tsk, u64 delay),
 	     TP_ARGS(tsk, delay));
 
+/*
+ * Tracepoint for the time from a wakeup until the task ran.
+ */
+DEFINE_EVENT(sched_stat_template, sched_stat_wakeup_latency,
+	     TP_PROTO(struct task_struct *tsk, u64 delay),
+	     TP_ARGS(tsk, delay));
+
+/*
+ * Tracepoint for the time a preempted task waited to run again.
+ */
+DEFINE_EVENT(sched_stat_template, sched_stat_preempt_latency,
+	     TP_PROTO(struct task_struct *tsk, u64 delay),
+	     TP_ARGS(tsk, delay));
+
 /*
  * Tracepoint for accounting runtime (time the task is executing
  * on a CPU).
@@ -391,6 +405,32 @@ TRACE_EVENT(sched_pi_setprio,
 			__entry->oldprio, __entry->newprio)
 );
 
+/*
+ * Tracepoint for the decayed per-cpu utilization and nr_running averages,
+ * emitted whenever the scheduler tick folds them.
+ */
+TRACE_EVENT(sched_load_avg,
+
+	TP_PROTO(int cpu, unsigned long util, unsigned long nr_avg),
+
+	TP_ARGS(cpu, util, nr_avg),
+
+	TP_STRUCT__entry(
+		__field( int,		cpu			)
+		__field( unsigned long,	util			)
+		__field( unsigned long,	nr_avg			)
+	),
+
+	TP_fast_assign(
+		__entry->cpu		= cpu;
+		__entry->util		= util;
+		__entry->nr_avg		= nr_avg;
+	),
+
+	TP_printk("cpu=%d util=%lu nr_avg=%lu",
+			__entry->cpu, __entry->util, __entry->nr_avg)
+);
+
 #endif /* _TRACE_SCHED_H */
 
 /* This part must be outside protection */
@@ -115,6 +115,46 @@ DEFINE_EVENT(workqueue_work, workqueue_execute_end,
 	TP_ARGS(work)
 );
 
+/**
+ * workqueue_execute_stats - called after a work item has been accounted
+ * @work:	pointer to struct work_struct, only the address is recorded
+ * @function:	the work function that ran
+ * @wq_name:	name of the workqueue it was queued on
+ * @latency_ns:	time between queueing and the start of execution
+ * @exec_ns:	time spent in the work function
+ *
+ * Only fires with CONFIG_WQ_STATS.
+ */
+TRACE_EVENT(workqueue_execute_stats,
+
+	TP_PROTO(struct work_struct *work, work_func_t function,
+		 const char *wq_name, u64 latency_ns, u64 exec_ns),
+
+	TP_ARGS(work, function, wq_name, latency_ns, exec_ns),
+
+	TP_STRUCT__entry(
+		__field( void *,	work		)
+		__field( void *,	function	)
+		__string( workqueue,	wq_name		)
+		__field( u64,		latency_ns	)
+		__field( u64,		exec_ns		)
+	),
+
+	TP_fast_assign(
+		__entry->work		= work;
+		__entry->function	= function;
+		__assign_str(workqueue, wq_name);
+		__entry->latency_ns	= latency_ns;
+		__entry->exec_ns	= exec_ns;
+	),
+
+	TP_printk("work struct %p: function %pf workqueue=%s latency_ns=%llu "
+		  "exec_ns=%llu", __entry->work, __entry->function,
+		  __get_str(workqueue),
+		  (unsigned long long)__entry->latency_ns,
+		  (unsigned long long)__entry->exec_ns)
+);
+
 #endif /*  _TRACE_WORKQUEUE_H */
 
 /* This part must be outside protection */
@@ -0,0 +1,125 @@
+/*
+ * kernel/lock_cstat.c
+ *
+ * Contention statistics for mutexes and rw_semaphores without lockdep.
+ *
+ * This software is licensed under the terms of the GNU General Public
+ * License version 2, as published by the Free Software Foundation, and
+ * may be copied, distributed, and modified under those terms.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ */
+
+#include <linux/kernel.h>
+#include <linux/init.h>
+#include <linux/debugfs.h>
+#include <linux/lock_cstat.h>
+#include <linux/percpu.h>
+#include <linux/sched.h>
+#include <linux/seq_file.h>
+
+/*
+ * Every slowpath entry is one contended acquisition.  It either ends in
+ * the optimistic spin loop or after queueing on the wait list; the wait
+ * is measured from slowpath entry to acquisition in both cases.
+ */
+struct lock_cstat {
+	unsigned long contended;
+	unsigned long spun;
+	unsigned long queued;
+	u64 wait_total;
+	u64 wait_max;
+};
+
+static DEFINE_PER_CPU(struct lock_cstat [LOCK_CSTAT_NR], lock_cstats);
+
+static const char * const lock_cstat_names[LOCK_CSTAT_NR] = {
+	[LOCK_CSTAT_MUTEX]		= "mutex",
+	[LOCK_CSTAT_RWSEM_READ]		= "rwsem_read",
+	[LOCK_CSTAT_RWSEM_WRITE]	= "rwsem_write",
+};
+
+u64 lock_cstat_clock(void)
+{
+	return local_clock();
+}
+
+void lock_cstat_account(enum lock_cstat_type type, bool spun, u64 start)
+{
+	struct lock_cstat *st;
+	u64 wait = local_clock() - start;
+
+	preempt_disable();
+	st = &__get_cpu_var(lock_cstats)[type];
+	st->contended++;
+	if (spun)
+		st->spun++;
+	else
+		st->queued++;
+	st->wait_total += wait;
+	if (wait > st->wait_max)
+		st->wait_max = wait;
+	preempt_enable();
+}
+
+static int lock_cstat_show(struct seq_file *m, void *unused)
+{
+	int type, cpu;
+
+	seq_printf(m, "%-12s %12s %12s %12s %16s %12s %12s\n", "type",
+		   "contended", "spun", "queued", "wait_total_ns",
+		   "wait_avg_ns", "wait_max_ns");
+
+	for (type = 0; type < LOCK_CSTAT_NR; type++) {
+		struct lock_cstat sum = { 0 };
+		u64 avg;
+
+		for_each_possible_cpu(cpu) {
+			struct lock_cstat *st;
+
+			st = &per_cpu(lock_cstats, cpu)[type];
+
+			sum.contended += st->contended;
+			sum.spun += st->spun;
+			sum.queued += st->queued;
+			sum.wait_total += st->wait_total;
+			sum.wait_max = max(sum.wait_max, st->wait_max);
+		}
+
+		avg = sum.wait_total;
+		if (sum.contended)
+			do_div(avg, sum.contended);
+
+		seq_printf(m, "%-12s %12lu %12lu %12lu %16llu %12llu %12llu\n",
+			   lock_cstat_names[type], sum.contended, sum.spun,
+			   sum.queued, (unsigned long long)sum.wait_total,
+			   (unsigned long long)avg,
+			   (unsigned long long)sum.wait_max);
+	}
+
+	return 0;
+}
+
+static int lock_cstat_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, lock_cstat_show, NULL);
+}
+
+static const struct file_operations lock_cstat_fops = {
+	.open		= lock_cstat_open,
+	.read		= seq_read,
+	.llseek		= seq_lseek,
+	.release	= single_release,
+};
+
+static int __init lock_cstat_init(void)
+{
+	debugfs_create_file("lock_contention", S_IRUGO, NULL, NULL,
+			    &lock_cstat_fops);
+	return 0;
+}
+late_initcall(lock_cstat_init);
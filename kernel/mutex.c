@@ -23,6 +23,8 @@
 #include <linux/spinlock.h>
 #include <linux/interrupt.h>
 #include <linux/debug_locks.h>
+#include <linux/lock_cstat.h>
+#include <linux/mcs_spinlock.h>
 
 /*
  * In the DEBUG case we are using the "NULL fastpath" for mutexes,
@@ -43,6 +45,9 @@ __mutex_init(struct mutex *lock, const char *name, struct lock_class_key *key)
 	spin_lock_init(&lock->wait_lock);
 	INIT_LIST_HEAD(&lock->wait_list);
 	mutex_clear_owner(lock);
+#ifdef CONFIG_MUTEX_SPIN_ON_OWNER
+	lock->spin_mlock = NULL;
+#endif
 
 	debug_mutex_init(lock, name, key);
 }
@@ -136,6 +141,10 @@ __mutex_lock_common(struct mutex *lock, long state, unsigned int subclass,
 	struct task_struct *task = current;
 	struct mutex_waiter waiter;
 	unsigned long flags;
+	u64 start = lock_cstat_clock();
+#ifdef CONFIG_MUTEX_SPIN_ON_OWNER
+	struct mcs_spinlock node;
+#endif
 
 	preempt_disable();
 	mutex_acquire_nest(&lock->dep_map, subclass, 0, nest_lock, ip);
@@ -157,8 +166,11 @@ __mutex_lock_common(struct mutex *lock, long state, unsigned int subclass,
 	 *
 	 * We can't do this for DEBUG_MUTEXES because that relies on wait_lock
 	 * to serialize everything.
+	 *
+	 * Spinners queue on an MCS lock first, so that only one of them at
+	 * a time polls lock->owner and lock->count.
 	 */
-
+	mcs_spin_lock(&lock->spin_mlock, &node);
 	for (;;) {
 		struct task_struct *owner;
 
@@ -173,7 +185,9 @@ __mutex_lock_common(struct mutex *lock, long state, unsigned int subclass,
 		if (atomic_cmpxchg(&lock->count, 1, 0) == 1) {
 			lock_acquired(&lock->dep_map, ip);
 			mutex_set_owner(lock);
+			mcs_spin_unlock(&lock->spin_mlock, &node);
 			preempt_enable();
+			lock_cstat_account(LOCK_CSTAT_MUTEX, true, start);
 			return 0;
 		}
 
@@ -194,6 +208,7 @@ __mutex_lock_common(struct mutex *lock, long state, unsigned int subclass,
 		 */
 		arch_mutex_cpu_relax();
 	}
+	mcs_spin_unlock(&lock->spin_mlock, &node);
 #endif
 	spin_lock_mutex(&lock->wait_lock, flags);
 
@@ -260,6 +275,7 @@ done:
 
 	debug_mutex_free_waiter(&waiter);
 	preempt_enable();
+	lock_cstat_account(LOCK_CSTAT_MUTEX, false, start);
 
 	return 0;
 }
@@ -13,10 +13,14 @@
  *
  */
 
+#include <linux/debugfs.h>
 #include <linux/earlysuspend.h>
 #include <linux/module.h>
 #include <linux/mutex.h>
 #include <linux/rtc.h>
+#include <linux/sched.h>
+#include <linux/seq_file.h>
+#include <linux/suspend_profile.h>
 #include <linux/wakelock.h>
 #include <linux/workqueue.h>
 
@@ -43,6 +47,7 @@ static void early_suspend(struct work_struct *work);
 static void late_resume(struct work_struct *work);
 static DECLARE_WORK(early_suspend_work, early_suspend);
 static DECLARE_WORK(late_resume_work, late_resume);
+static struct workqueue_struct *early_suspend_async_wq;
 static DEFINE_SPINLOCK(state_lock);
 enum {
 	SUSPEND_REQUESTED = 0x1,
@@ -61,10 +66,50 @@ static DECLARE_WORK(onchg_resume_work, onchg_resume);
 static int state_onchg;
 #endif
 
+static void early_suspend_call(struct early_suspend *handler, bool resume)
+{
+	void (*fn)(struct early_suspend *h);
+	u64 prof_start = suspend_prof_clock();
+	u64 start = local_clock();
+
+	fn = resume ? handler->resume : handler->suspend;
+	if (debug_mask & DEBUG_VERBOSE)
+		pr_info("%s: calling %pf\n",
+			resume ? "late_resume" : "early_suspend", fn);
+	fn(handler);
+	if (resume)
+		handler->resume_ns = local_clock() - start;
+	else
+		handler->suspend_ns = local_clock() - start;
+	suspend_prof_handler(fn, prof_start);
+}
+
+static void early_suspend_async_suspend(struct work_struct *work)
+{
+	early_suspend_call(container_of(work, struct early_suspend,
+					suspend_work), false);
+}
+
+static void early_suspend_async_resume(struct work_struct *work)
+{
+	early_suspend_call(container_of(work, struct early_suspend,
+					resume_work), true);
+}
+
+static bool early_suspend_is_async(struct early_suspend *handler)
+{
+	return (handler->flags & EARLY_SUSPEND_ASYNC) && early_suspend_async_wq;
+}
+
 void register_early_suspend(struct early_suspend *handler)
 {
 	struct list_head *pos;
 
+	INIT_WORK(&handler->suspend_work, early_suspend_async_suspend);
+	INIT_WORK(&handler->resume_work, early_suspend_async_resume);
+	handler->suspend_ns = 0;
+	handler->resume_ns = 0;
+
 	mutex_lock(&early_suspend_lock);
 	list_for_each(pos, &early_suspend_handlers) {
 		struct early_suspend *e;
@@ -84,6 +129,8 @@ void unregister_early_suspend(struct early_suspend *handler)
 	mutex_lock(&early_suspend_lock);
 	list_del(&handler->link);
 	mutex_unlock(&early_suspend_lock);
+	flush_work_sync(&handler->suspend_work);
+	flush_work_sync(&handler->resume_work);
 }
 EXPORT_SYMBOL(unregister_early_suspend);
 
@@ -113,15 +160,26 @@ static void early_suspend(struct work_struct *work)
 		goto abort;
 	}
 
+	/* async resumes of the previous late_resume may still be running */
+	if (early_suspend_async_wq)
+		flush_workqueue(early_suspend_async_wq);
+
 	if (debug_mask & DEBUG_SUSPEND)
 		pr_info("early_suspend: call handlers\n");
+	suspend_prof_cycle_begin(SUSPEND_PROF_CYCLE_EARLY_SUSPEND);
+	suspend_prof_stage_begin(SUSPEND_PROF_EARLY_SUSPEND);
 	list_for_each_entry(pos, &early_suspend_handlers, link) {
-		if (pos->suspend != NULL) {
-			if (debug_mask & DEBUG_VERBOSE)
-				pr_info("early_suspend: calling %pf\n", pos->suspend);
-			pos->suspend(pos);
-		}
+		if (pos->suspend != NULL && early_suspend_is_async(pos))
+			queue_work(early_suspend_async_wq, &pos->suspend_work);
 	}
+	list_for_each_entry(pos, &early_suspend_handlers, link) {
+		if (pos->suspend != NULL && !early_suspend_is_async(pos))
+			early_suspend_call(pos, false);
+	}
+	if (early_suspend_async_wq)
+		flush_workqueue(early_suspend_async_wq);
+	suspend_prof_stage_end(SUSPEND_PROF_EARLY_SUSPEND);
+	suspend_prof_cycle_end(0);
 	mutex_unlock(&early_suspend_lock);
 
 	suspend_sys_sync_queue();
@@ -165,13 +223,22 @@ static void late_resume(struct work_struct *work)
 	}
 	if (debug_mask & DEBUG_SUSPEND)
 		pr_info("late_resume: call handlers\n");
+	suspend_prof_cycle_begin(SUSPEND_PROF_CYCLE_LATE_RESUME);
+	suspend_prof_stage_begin(SUSPEND_PROF_LATE_RESUME);
 	list_for_each_entry_reverse(pos, &early_suspend_handlers, link) {
-		if (pos->resume != NULL) {
-			if (debug_mask & DEBUG_VERBOSE)
-				pr_info("late_resume: calling %pf\n", pos->resume);
+		if (pos->resume != NULL && !early_suspend_is_async(pos))
+			early_suspend_call(pos, true);
+	}
+	suspend_prof_stage_end(SUSPEND_PROF_LATE_RESUME);
+	suspend_prof_cycle_end(0);
 
-			pos->resume(pos);
-		}
+	/*
+	 * The display is back at this point; let the handlers that nothing
+	 * depends on finish in parallel instead of delaying the first frame.
+	 */
+	list_for_each_entry_reverse(pos, &early_suspend_handlers, link) {
+		if (pos->resume != NULL && early_suspend_is_async(pos))
+			queue_work(early_suspend_async_wq, &pos->resume_work);
 	}
 	if (debug_mask & DEBUG_SUSPEND)
 		pr_info("late_resume: done\n");
@@ -351,3 +418,47 @@ suspend_state_t get_suspend_state(void)
 {
 	return requested_suspend_state;
 }
+
+static int early_suspend_handlers_show(struct seq_file *m, void *unused)
+{
+	struct early_suspend *pos;
+
+	seq_printf(m, "%-6s %-5s %12s %12s %s\n",
+		   "level", "async", "suspend_us", "resume_us", "handler");
+	mutex_lock(&early_suspend_lock);
+	list_for_each_entry(pos, &early_suspend_handlers, link) {
+		seq_printf(m, "%-6d %-5s %12llu %12llu %pf\n", pos->level,
+			   pos->flags & EARLY_SUSPEND_ASYNC ? "yes" : "no",
+			   div_u64(pos->suspend_ns, NSEC_PER_USEC),
+			   div_u64(pos->resume_ns, NSEC_PER_USEC),
+			   pos->suspend ? (void *)pos->suspend :
+					  (void *)pos->resume);
+	}
+	mutex_unlock(&early_suspend_lock);
+	return 0;
+}
+
+static int early_suspend_handlers_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, early_suspend_handlers_show, NULL);
+}
+
+static const struct file_operations early_suspend_handlers_fops = {
+	.open = early_suspend_handlers_open,
+	.read = seq_read,
+	.llseek = seq_lseek,
+	.release = single_release,
+};
+
+static int __init early_suspend_init(void)
+{
+	early_suspend_async_wq = alloc_workqueue("early_suspend_async",
+						 WQ_UNBOUND | WQ_HIGHPRI, 0);
+	if (!early_suspend_async_wq)
+		pr_err("early_suspend: failed to create async workqueue\n");
+
+	debugfs_create_file("early_suspend_handlers", S_IRUGO, NULL, NULL,
+			    &early_suspend_handlers_fops);
+	return 0;
+}
+postcore_initcall(early_suspend_init);
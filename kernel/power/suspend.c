@@ -22,6 +22,7 @@
 #include <linux/mm.h>
 #include <linux/slab.h>
 #include <linux/suspend.h>
+#include <linux/suspend_profile.h>
 #include <linux/syscore_ops.h>
 #include <linux/ftrace.h>
 #include <trace/events/power.h>
@@ -105,7 +106,9 @@ static int suspend_prepare(void)
 	if (error)
 		goto Finish;
 
+	suspend_prof_stage_begin(SUSPEND_PROF_FREEZE);
 	error = suspend_freeze_processes();
+	suspend_prof_stage_end(SUSPEND_PROF_FREEZE);
 	if (!error)
 		return 0;
 
@@ -145,7 +148,9 @@ static int suspend_enter(suspend_state_t state)
 			goto Platform_finish;
 	}
 
+	suspend_prof_stage_begin(SUSPEND_PROF_DPM_SUSPEND_NOIRQ);
 	error = dpm_suspend_noirq(PMSG_SUSPEND);
+	suspend_prof_stage_end(SUSPEND_PROF_DPM_SUSPEND_NOIRQ);
 	if (error) {
 		printk(KERN_ERR "PM: Some devices failed to power down\n");
 		goto Platform_finish;
@@ -167,13 +172,19 @@ static int suspend_enter(suspend_state_t state)
 	arch_suspend_disable_irqs();
 	BUG_ON(!irqs_disabled());
 
+	suspend_prof_stage_begin(SUSPEND_PROF_SYSCORE_SUSPEND);
 	error = syscore_suspend();
+	suspend_prof_stage_end(SUSPEND_PROF_SYSCORE_SUSPEND);
 	if (!error) {
 		if (!(suspend_test(TEST_CORE) || pm_wakeup_pending())) {
+			suspend_prof_stage_begin(SUSPEND_PROF_PLATFORM);
 			error = suspend_ops->enter(state);
+			suspend_prof_stage_end(SUSPEND_PROF_PLATFORM);
 			events_check_enabled = false;
 		}
+		suspend_prof_stage_begin(SUSPEND_PROF_SYSCORE_RESUME);
 		syscore_resume();
+		suspend_prof_stage_end(SUSPEND_PROF_SYSCORE_RESUME);
 	}
 
 	arch_suspend_enable_irqs();
@@ -186,7 +197,9 @@ static int suspend_enter(suspend_state_t state)
 	if (suspend_ops->wake)
 		suspend_ops->wake();
 
+	suspend_prof_stage_begin(SUSPEND_PROF_DPM_RESUME_NOIRQ);
 	dpm_resume_noirq(PMSG_RESUME);
+	suspend_prof_stage_end(SUSPEND_PROF_DPM_RESUME_NOIRQ);
 
  Platform_finish:
 	if (suspend_ops->finish)
@@ -217,7 +230,9 @@ int suspend_devices_and_enter(suspend_state_t state)
 		suspend_console();
 	ftrace_stop();
 	suspend_test_start();
+	suspend_prof_stage_begin(SUSPEND_PROF_DPM_SUSPEND);
 	error = dpm_suspend_start(PMSG_SUSPEND);
+	suspend_prof_stage_end(SUSPEND_PROF_DPM_SUSPEND);
 	if (error) {
 		printk(KERN_ERR "PM: Some devices failed to suspend\n");
 		goto Recover_platform;
@@ -230,7 +245,9 @@ int suspend_devices_and_enter(suspend_state_t state)
 
  Resume_devices:
 	suspend_test_start();
+	suspend_prof_stage_begin(SUSPEND_PROF_DPM_RESUME);
 	dpm_resume_end(PMSG_RESUME);
+	suspend_prof_stage_end(SUSPEND_PROF_DPM_RESUME);
 	suspend_test_finish("resume devices");
 	ftrace_start();
 	if (!suspend_console_deferred)
@@ -255,7 +272,9 @@ int suspend_devices_and_enter(suspend_state_t state)
  */
 static void suspend_finish(void)
 {
+	suspend_prof_stage_begin(SUSPEND_PROF_THAW);
 	suspend_thaw_processes();
+	suspend_prof_stage_end(SUSPEND_PROF_THAW);
 	usermodehelper_enable();
 	pm_notifier_call_chain(PM_POST_SUSPEND);
 	pm_restore_console();
@@ -283,6 +302,7 @@ int enter_state(suspend_state_t state)
 
 	suspend_sys_sync_queue();
 
+	suspend_prof_cycle_begin(SUSPEND_PROF_CYCLE_SUSPEND);
 	pr_debug("PM: Preparing system for %s sleep\n", pm_states[state]);
 	error = suspend_prepare();
 	if (error)
@@ -300,6 +320,7 @@ int enter_state(suspend_state_t state)
 	pr_debug("PM: Finishing wakeup.\n");
 	suspend_finish();
  Unlock:
+	suspend_prof_cycle_end(error);
 	mutex_unlock(&pm_mutex);
 	return error;
 }
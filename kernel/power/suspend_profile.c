@@ -0,0 +1,460 @@
+/* kernel/power/suspend_profile.c
+ *
+ * Suspend/resume latency profiler.
+ *
+ * Timestamps every stage of early suspend, system suspend and late resume,
+ * keeps the slowest early suspend handlers and device callbacks of each
+ * cycle, stores the last CONFIG_PM_SUSPEND_PROFILE_CYCLES cycles in a ring
+ * and exports per-stage statistics and log2 histograms in
+ * /sys/kernel/debug/suspend_profile.
+ *
+ * This software is licensed under the terms of the GNU General Public
+ * License version 2, as published by the Free Software Foundation, and
+ * may be copied, distributed, and modified under those terms.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ */
+
+#include <linux/debugfs.h>
+#include <linux/device.h>
+#include <linux/init.h>
+#include <linux/kallsyms.h>
+#include <linux/kernel.h>
+#include <linux/log2.h>
+#include <linux/module.h>
+#include <linux/sched.h>
+#include <linux/seq_file.h>
+#include <linux/spinlock.h>
+#include <linux/string.h>
+#include <linux/suspend_profile.h>
+#include <linux/time.h>
+#include <trace/events/power.h>
+
+#define SUSPEND_PROF_SLOWEST		8
+#define SUSPEND_PROF_NAME_LEN		32
+#define SUSPEND_PROF_HIST_BUCKETS	24	/* 1us .. 8s */
+
+struct suspend_prof_slow {
+	u64 ns;
+	enum suspend_prof_stage stage;
+	char name[SUSPEND_PROF_NAME_LEN];
+};
+
+struct suspend_prof_record {
+	unsigned int seq;
+	enum suspend_prof_cycle kind;
+	int error;
+	struct timespec ts;
+	u64 start;
+	u64 total_ns;
+	unsigned long stage_mask;
+	u64 stage_ns[SUSPEND_PROF_NR_STAGES];
+	int nr_slow;
+	struct suspend_prof_slow slow[SUSPEND_PROF_SLOWEST];
+};
+
+struct suspend_prof_stats {
+	unsigned long count;
+	u64 total_ns;
+	u64 max_ns;
+	u64 last_ns;
+	unsigned long hist[SUSPEND_PROF_HIST_BUCKETS];
+};
+
+static const char *const suspend_prof_cycle_names[SUSPEND_PROF_CYCLE_NR] = {
+	[SUSPEND_PROF_CYCLE_EARLY_SUSPEND]	= "early_suspend",
+	[SUSPEND_PROF_CYCLE_SUSPEND]		= "suspend",
+	[SUSPEND_PROF_CYCLE_LATE_RESUME]	= "late_resume",
+};
+
+static const char *const suspend_prof_stage_names[SUSPEND_PROF_NR_STAGES] = {
+	[SUSPEND_PROF_EARLY_SUSPEND]		= "early_suspend",
+	[SUSPEND_PROF_FREEZE]			= "freeze",
+	[SUSPEND_PROF_DPM_SUSPEND]		= "dpm_suspend",
+	[SUSPEND_PROF_DPM_SUSPEND_NOIRQ]	= "dpm_suspend_noirq",
+	[SUSPEND_PROF_SYSCORE_SUSPEND]		= "syscore_suspend",
+	[SUSPEND_PROF_PLATFORM]			= "platform",
+	[SUSPEND_PROF_PLATFORM_ENTER]		= "platform_enter",
+	[SUSPEND_PROF_PLATFORM_EXIT]		= "platform_exit",
+	[SUSPEND_PROF_SYSCORE_RESUME]		= "syscore_resume",
+	[SUSPEND_PROF_DPM_RESUME_NOIRQ]		= "dpm_resume_noirq",
+	[SUSPEND_PROF_DPM_RESUME]		= "dpm_resume",
+	[SUSPEND_PROF_THAW]			= "thaw",
+	[SUSPEND_PROF_LATE_RESUME]		= "late_resume",
+};
+
+static int enabled = 1;
+module_param_named(enabled, enabled, int, S_IRUGO | S_IWUSR | S_IWGRP);
+
+static DEFINE_SPINLOCK(suspend_prof_lock);
+static bool cycle_open;
+static enum suspend_prof_stage cur_stage;
+static unsigned long stage_active;
+static u64 stage_start[SUSPEND_PROF_NR_STAGES];
+static struct suspend_prof_record cur;
+static struct suspend_prof_record ring[CONFIG_PM_SUSPEND_PROFILE_CYCLES];
+static unsigned int nr_cycles;
+static struct suspend_prof_stats stage_stats[SUSPEND_PROF_NR_STAGES];
+static struct suspend_prof_stats cycle_stats[SUSPEND_PROF_CYCLE_NR];
+
+static inline unsigned long ns_to_us(u64 ns)
+{
+	do_div(ns, NSEC_PER_USEC);
+	return (unsigned long)ns;
+}
+
+/*
+ * sched_clock() based so that it keeps working between syscore_suspend()
+ * and syscore_resume(), where timekeeping is already suspended.  Time spent
+ * in power collapse is only counted if the platform sched_clock keeps
+ * running, which is why the collapse itself is bracketed separately.
+ */
+u64 suspend_prof_clock(void)
+{
+	return local_clock();
+}
+
+static void suspend_prof_account(struct suspend_prof_stats *stats, u64 ns)
+{
+	unsigned long us = ns_to_us(ns);
+	int bucket = us ? ilog2(us) : 0;
+
+	if (bucket >= SUSPEND_PROF_HIST_BUCKETS)
+		bucket = SUSPEND_PROF_HIST_BUCKETS - 1;
+	stats->count++;
+	stats->total_ns += ns;
+	stats->last_ns = ns;
+	if (ns > stats->max_ns)
+		stats->max_ns = ns;
+	stats->hist[bucket]++;
+}
+
+/* Latency of a cycle, i.e. its length minus the time spent asleep. */
+static u64 suspend_prof_latency(struct suspend_prof_record *rec)
+{
+	u64 asleep = rec->stage_ns[SUSPEND_PROF_PLATFORM];
+	u64 awake = rec->stage_ns[SUSPEND_PROF_PLATFORM_ENTER] +
+		    rec->stage_ns[SUSPEND_PROF_PLATFORM_EXIT];
+
+	if (rec->stage_mask & BIT(SUSPEND_PROF_PLATFORM_ENTER))
+		asleep -= min(asleep, awake);
+	else
+		asleep = 0;
+
+	return rec->total_ns - min(rec->total_ns, asleep);
+}
+
+void suspend_prof_cycle_begin(enum suspend_prof_cycle kind)
+{
+	unsigned long irqflags;
+
+	if (!enabled)
+		return;
+
+	spin_lock_irqsave(&suspend_prof_lock, irqflags);
+	memset(&cur, 0, sizeof(cur));
+	cur.kind = kind;
+	getnstimeofday(&cur.ts);
+	cur.start = suspend_prof_clock();
+	stage_active = 0;
+	cycle_open = true;
+	spin_unlock_irqrestore(&suspend_prof_lock, irqflags);
+}
+
+void suspend_prof_cycle_end(int error)
+{
+	unsigned long irqflags;
+	u64 now = suspend_prof_clock();
+
+	spin_lock_irqsave(&suspend_prof_lock, irqflags);
+	if (!cycle_open)
+		goto out;
+
+	cycle_open = false;
+	cur.error = error;
+	cur.total_ns = now - cur.start;
+	cur.seq = nr_cycles;
+	ring[nr_cycles % ARRAY_SIZE(ring)] = cur;
+	nr_cycles++;
+	suspend_prof_account(&cycle_stats[cur.kind],
+			     suspend_prof_latency(&cur));
+out:
+	spin_unlock_irqrestore(&suspend_prof_lock, irqflags);
+}
+
+void suspend_prof_stage_begin(enum suspend_prof_stage stage)
+{
+	unsigned long irqflags;
+
+	if (!cycle_open)
+		return;
+
+	trace_suspend_resume_stage(suspend_prof_stage_names[stage], true);
+
+	spin_lock_irqsave(&suspend_prof_lock, irqflags);
+	cur_stage = stage;
+	stage_active |= BIT(stage);
+	stage_start[stage] = suspend_prof_clock();
+	spin_unlock_irqrestore(&suspend_prof_lock, irqflags);
+}
+
+void suspend_prof_stage_end(enum suspend_prof_stage stage)
+{
+	unsigned long irqflags;
+	u64 now = suspend_prof_clock();
+	u64 delta;
+
+	if (!cycle_open)
+		return;
+
+	trace_suspend_resume_stage(suspend_prof_stage_names[stage], false);
+
+	spin_lock_irqsave(&suspend_prof_lock, irqflags);
+	if (!(stage_active & BIT(stage)))
+		goto out;
+
+	stage_active &= ~BIT(stage);
+	delta = now - stage_start[stage];
+	cur.stage_mask |= BIT(stage);
+	cur.stage_ns[stage] += delta;
+	suspend_prof_account(&stage_stats[stage], delta);
+out:
+	spin_unlock_irqrestore(&suspend_prof_lock, irqflags);
+}
+
+/* Keep the SUSPEND_PROF_SLOWEST slowest callbacks of the cycle, sorted. */
+static void suspend_prof_callback(const char *name, u64 start)
+{
+	unsigned long irqflags;
+	u64 delta = suspend_prof_clock() - start;
+	struct suspend_prof_slow *slot;
+	int i;
+
+	trace_suspend_resume_callback(name, suspend_prof_stage_names[cur_stage],
+				      delta);
+
+	spin_lock_irqsave(&suspend_prof_lock, irqflags);
+	if (!cycle_open)
+		goto out;
+
+	for (i = cur.nr_slow; i > 0; i--)
+		if (cur.slow[i - 1].ns >= delta)
+			break;
+	if (i >= SUSPEND_PROF_SLOWEST)
+		goto out;
+
+	if (cur.nr_slow < SUSPEND_PROF_SLOWEST)
+		cur.nr_slow++;
+	memmove(&cur.slow[i + 1], &cur.slow[i],
+		(cur.nr_slow - i - 1) * sizeof(cur.slow[0]));
+	slot = &cur.slow[i];
+	slot->ns = delta;
+	slot->stage = cur_stage;
+	strlcpy(slot->name, name, sizeof(slot->name));
+out:
+	spin_unlock_irqrestore(&suspend_prof_lock, irqflags);
+}
+
+void suspend_prof_handler(void *fn, u64 start)
+{
+	char name[KSYM_SYMBOL_LEN];
+
+	if (!cycle_open)
+		return;
+
+	snprintf(name, sizeof(name), "%pf", fn);
+	suspend_prof_callback(name, start);
+}
+
+void suspend_prof_device(struct device *dev, u64 start)
+{
+	if (!cycle_open)
+		return;
+
+	suspend_prof_callback(dev_name(dev), start);
+}
+
+static void suspend_prof_print_us(struct seq_file *m, u64 ns)
+{
+	seq_printf(m, " %10lu", ns_to_us(ns));
+}
+
+static int suspend_prof_cycles_show(struct seq_file *m, void *unused)
+{
+	struct suspend_prof_record *rec;
+	unsigned long irqflags;
+	unsigned int first, seq;
+	int i;
+
+	spin_lock_irqsave(&suspend_prof_lock, irqflags);
+	first = nr_cycles > ARRAY_SIZE(ring) ? nr_cycles - ARRAY_SIZE(ring) : 0;
+	for (seq = first; seq < nr_cycles; seq++) {
+		rec = &ring[seq % ARRAY_SIZE(ring)];
+		seq_printf(m, "cycle %u %s at %lu.%06lu error %d\n",
+			   rec->seq, suspend_prof_cycle_names[rec->kind],
+			   (unsigned long)rec->ts.tv_sec,
+			   rec->ts.tv_nsec / NSEC_PER_USEC, rec->error);
+		seq_printf(m, "  %-24s", "total_us");
+		suspend_prof_print_us(m, rec->total_ns);
+		seq_printf(m, "\n  %-24s", "latency_us");
+		suspend_prof_print_us(m, suspend_prof_latency(rec));
+		seq_putc(m, '\n');
+		for (i = 0; i < SUSPEND_PROF_NR_STAGES; i++) {
+			if (!(rec->stage_mask & BIT(i)))
+				continue;
+			seq_printf(m, "  %-24s", suspend_prof_stage_names[i]);
+			suspend_prof_print_us(m, rec->stage_ns[i]);
+			seq_putc(m, '\n');
+		}
+		for (i = 0; i < rec->nr_slow; i++) {
+			seq_printf(m, "  slow %-19s",
+				   suspend_prof_stage_names[rec->slow[i].stage]);
+			suspend_prof_print_us(m, rec->slow[i].ns);
+			seq_printf(m, " %s\n", rec->slow[i].name);
+		}
+	}
+	spin_unlock_irqrestore(&suspend_prof_lock, irqflags);
+	return 0;
+}
+
+static void suspend_prof_stats_show(struct seq_file *m, const char *name,
+				    struct suspend_prof_stats *stats)
+{
+	u64 avg = stats->total_ns;
+
+	if (stats->count)
+		do_div(avg, stats->count);
+	seq_printf(m, "%-24s %8lu", name, stats->count);
+	suspend_prof_print_us(m, avg);
+	suspend_prof_print_us(m, stats->max_ns);
+	suspend_prof_print_us(m, stats->last_ns);
+	seq_putc(m, '\n');
+}
+
+static int suspend_prof_stages_show(struct seq_file *m, void *unused)
+{
+	unsigned long irqflags;
+	int i;
+
+	seq_printf(m, "%-24s %8s %10s %10s %10s\n",
+		   "name", "count", "avg_us", "max_us", "last_us");
+	spin_lock_irqsave(&suspend_prof_lock, irqflags);
+	for (i = 0; i < SUSPEND_PROF_CYCLE_NR; i++)
+		suspend_prof_stats_show(m, suspend_prof_cycle_names[i],
+					&cycle_stats[i]);
+	for (i = 0; i < SUSPEND_PROF_NR_STAGES; i++)
+		suspend_prof_stats_show(m, suspend_prof_stage_names[i],
+					&stage_stats[i]);
+	spin_unlock_irqrestore(&suspend_prof_lock, irqflags);
+	return 0;
+}
+
+static void suspend_prof_hist_show(struct seq_file *m, const char *name,
+				   struct suspend_prof_stats *stats)
+{
+	int i;
+
+	seq_printf(m, "%-24s", name);
+	for (i = 0; i < SUSPEND_PROF_HIST_BUCKETS; i++)
+		seq_printf(m, " %lu", stats->hist[i]);
+	seq_putc(m, '\n');
+}
+
+static int suspend_prof_histogram_show(struct seq_file *m, void *unused)
+{
+	unsigned long irqflags;
+	int i;
+
+	/* column i counts samples in [2^i, 2^(i+1)) usecs */
+	seq_printf(m, "%-24s", "usecs");
+	for (i = 0; i < SUSPEND_PROF_HIST_BUCKETS; i++)
+		seq_printf(m, " %lu", 1UL << i);
+	seq_putc(m, '\n');
+	spin_lock_irqsave(&suspend_prof_lock, irqflags);
+	for (i = 0; i < SUSPEND_PROF_CYCLE_NR; i++)
+		suspend_prof_hist_show(m, suspend_prof_cycle_names[i],
+				       &cycle_stats[i]);
+	for (i = 0; i < SUSPEND_PROF_NR_STAGES; i++)
+		suspend_prof_hist_show(m, suspend_prof_stage_names[i],
+				       &stage_stats[i]);
+	spin_unlock_irqrestore(&suspend_prof_lock, irqflags);
+	return 0;
+}
+
+static ssize_t suspend_prof_reset_write(struct file *file,
+					const char __user *buf,
+					size_t count, loff_t *ppos)
+{
+	unsigned long irqflags;
+
+	spin_lock_irqsave(&suspend_prof_lock, irqflags);
+	memset(stage_stats, 0, sizeof(stage_stats));
+	memset(cycle_stats, 0, sizeof(cycle_stats));
+	nr_cycles = 0;
+	spin_unlock_irqrestore(&suspend_prof_lock, irqflags);
+	return count;
+}
+
+static int suspend_prof_cycles_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, suspend_prof_cycles_show, NULL);
+}
+
+static int suspend_prof_stages_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, suspend_prof_stages_show, NULL);
+}
+
+static int suspend_prof_histogram_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, suspend_prof_histogram_show, NULL);
+}
+
+static const struct file_operations suspend_prof_cycles_fops = {
+	.open = suspend_prof_cycles_open,
+	.read = seq_read,
+	.llseek = seq_lseek,
+	.release = single_release,
+};
+
+static const struct file_operations suspend_prof_stages_fops = {
+	.open = suspend_prof_stages_open,
+	.read = seq_read,
+	.llseek = seq_lseek,
+	.release = single_release,
+};
+
+static const struct file_operations suspend_prof_histogram_fops = {
+	.open = suspend_prof_histogram_open,
+	.read = seq_read,
+	.llseek = seq_lseek,
+	.release = single_release,
+};
+
+static const struct file_operations suspend_prof_reset_fops = {
+	.write = suspend_prof_reset_write,
+};
+
+static int __init suspend_prof_init(void)
+{
+	struct dentry *dir;
+
+	dir = debugfs_create_dir("suspend_profile", NULL);
+	if (IS_ERR_OR_NULL(dir))
+		return -ENOMEM;
+
+	debugfs_create_file("cycles", S_IRUGO, dir, NULL,
+			    &suspend_prof_cycles_fops);
+	debugfs_create_file("stages", S_IRUGO, dir, NULL,
+			    &suspend_prof_stages_fops);
+	debugfs_create_file("histogram", S_IRUGO, dir, NULL,
+			    &suspend_prof_histogram_fops);
+	debugfs_create_file("reset", S_IWUSR, dir, NULL,
+			    &suspend_prof_reset_fops);
+	return 0;
+}
+late_initcall(suspend_prof_init);
@@ -41,6 +41,7 @@
 #include <linux/cpu.h>
 #include <linux/notifier.h>
 #include <linux/rculist.h>
+#include <linux/kthread.h>
 
 #include <asm/uaccess.h>
 
@@ -142,6 +143,16 @@ EXPORT_SYMBOL(console_set_on_cmdline);
 /* Flag: console code may call schedule() */
 static int console_may_schedule;
 
+/*
+ * Work for printk_tick(): waking up klogd and, with per-cpu printk
+ * buffers, kprintkd.  Neither can be woken from printk() directly since
+ * it may be called with runqueue locks held.
+ */
+#define PRINTK_PENDING_WAKEUP	0x01
+#define PRINTK_PENDING_OUTPUT	0x02
+
+static DEFINE_PER_CPU(int, printk_pending);
+
 #ifdef CONFIG_PRINTK
 
 static char __log_buf[__LOG_BUF_LEN];
@@ -888,58 +899,22 @@ static inline void printk_delay(void)
 	}
 }
 
-asmlinkage int vprintk(const char *fmt, va_list args)
+/*
+ * Copy a formatted message into log_buf, adding the log level and time
+ * stamp prefixes where a new line starts.  @ts is the cpu_clock() value
+ * for when the message was printed.  Returns the number of prefix
+ * characters added.
+ *
+ * Called with logbuf_lock held.
+ */
+static int log_store(const char *text, u64 ts)
 {
-	int printed_len = 0;
 	int current_log_level = default_message_loglevel;
-	unsigned long flags;
-	int this_cpu;
-	char *p;
+	const char *p = text;
+	int printed_len = 0;
 	size_t plen;
 	char special;
 
-	boot_delay_msec();
-	printk_delay();
-
-	preempt_disable();
-	/* This stops the holder of console_sem just where we want him */
-	raw_local_irq_save(flags);
-	this_cpu = smp_processor_id();
-
-	/*
-	 * Ouch, printk recursed into itself!
-	 */
-	if (unlikely(printk_cpu == this_cpu)) {
-		/*
-		 * If a crash is occurring during printk() on this CPU,
-		 * then try to get the crash message out but make sure
-		 * we can't deadlock. Otherwise just return to avoid the
-		 * recursion and return - but flag the recursion so that
-		 * it can be printed at the next appropriate moment:
-		 */
-		if (!oops_in_progress) {
-			recursion_bug = 1;
-			goto out_restore_irqs;
-		}
-		zap_locks();
-	}
-
-	lockdep_off();
-	spin_lock(&logbuf_lock);
-	printk_cpu = this_cpu;
-
-	if (recursion_bug) {
-		recursion_bug = 0;
-		strcpy(printk_buf, recursion_bug_msg);
-		printed_len = strlen(recursion_bug_msg);
-	}
-	/* Emit the output into the temporary buffer */
-	printed_len += vscnprintf(printk_buf + printed_len,
-				  sizeof(printk_buf) - printed_len, fmt, args);
-
-
-	p = printk_buf;
-
 	/* Read log level and handle special printk prefix */
 	plen = log_prefix(p, &current_log_level, &special);
 	if (plen) {
@@ -972,7 +947,7 @@ asmlinkage int vprintk(const char *fmt, va_list args)
 				int i;
 
 				for (i = 0; i < plen; i++)
-					emit_log_char(printk_buf[i]);
+					emit_log_char(text[i]);
 				printed_len += plen;
 			} else {
 				/* Add log prefix */
@@ -986,10 +961,9 @@ asmlinkage int vprintk(const char *fmt, va_list args)
 				/* Add the current time stamp */
 				char tbuf[50], *tp;
 				unsigned tlen;
-				unsigned long long t;
+				unsigned long long t = ts;
 				unsigned long nanosec_rem;
 
-				t = cpu_clock(printk_cpu);
 				nanosec_rem = do_div(t, 1000000000);
 				tlen = sprintf(tbuf, "[%5lu.%06lu] ",
 						(unsigned long) t,
@@ -1009,6 +983,301 @@ asmlinkage int vprintk(const char *fmt, va_list args)
 			new_text_line = 1;
 	}
 
+	return printed_len;
+}
+
+#ifdef CONFIG_PRINTK_PERCPU
+/*
+ * Per-cpu printk buffers.
+ *
+ * Each cpu formats its messages into its own ring without taking any
+ * lock; the owning cpu is the only writer of ->head and, with interrupts
+ * disabled, the only one touching ->text.  Records carry a global
+ * sequence number and kprintkd, holding logbuf_lock, repeatedly moves
+ * the lowest numbered record of all cpus into log_buf, which makes it
+ * the only writer of ->tail.  A record that does not fit is dropped and
+ * counted rather than waiting for kprintkd.
+ *
+ * A record never wraps: if it does not fit before the end of the ring,
+ * the rest of the ring is skipped, marked by a zero ->size when there is
+ * room for a header and implied otherwise.
+ */
+#define PRINTK_PCPU_SIZE	(1 << CONFIG_PRINTK_PERCPU_BUF_SHIFT)
+#define PRINTK_PCPU_MASK	(PRINTK_PCPU_SIZE - 1)
+
+struct printk_rec {
+	unsigned long		seq;
+	u64			ts;
+	unsigned short		size;	/* whole record, 0: skip to end */
+	unsigned short		len;	/* of text, without the NUL */
+	char			text[0];
+};
+
+struct printk_pcpu {
+	unsigned long		head;
+	unsigned long		tail;
+	unsigned long		dropped;
+	unsigned long		dropped_seen;	/* logbuf_lock */
+	int			busy;
+	char			text[1024];
+	char			buf[PRINTK_PCPU_SIZE];
+};
+
+static DEFINE_PER_CPU(struct printk_pcpu, printk_pcpu);
+static atomic_long_t printk_seq;
+static struct task_struct *printk_kthread;
+static int printk_pcpu_enabled __read_mostly;
+
+static void printk_pcpu_store(struct printk_pcpu *pc, size_t len, u64 ts)
+{
+	size_t size = ALIGN(sizeof(struct printk_rec) + len + 1, sizeof(u64));
+	unsigned long head = pc->head;
+	unsigned long tail = ACCESS_ONCE(pc->tail);
+	unsigned int off = head & PRINTK_PCPU_MASK;
+	unsigned int pad = 0;
+	struct printk_rec *rec;
+
+	/* read ->tail before reusing the space kprintkd gave back */
+	smp_mb();
+
+	if (off + size > PRINTK_PCPU_SIZE)
+		pad = PRINTK_PCPU_SIZE - off;
+	if (pad + size > PRINTK_PCPU_SIZE - (head - tail)) {
+		pc->dropped++;
+		return;
+	}
+	if (pad >= sizeof(*rec)) {
+		rec = (struct printk_rec *)(pc->buf + off);
+		rec->size = 0;
+	}
+	head += pad;
+
+	rec = (struct printk_rec *)(pc->buf + (head & PRINTK_PCPU_MASK));
+	rec->seq = atomic_long_inc_return(&printk_seq);
+	rec->ts = ts;
+	rec->size = size;
+	rec->len = len;
+	memcpy(rec->text, pc->text, len + 1);
+
+	/* publish the record before the new ->head */
+	smp_wmb();
+	pc->head = head + size;
+}
+
+static int vprintk_pcpu(const char *fmt, va_list args)
+{
+	struct printk_pcpu *pc = &__get_cpu_var(printk_pcpu);
+	int len;
+
+	/* an NMI or a recursive printk() would scribble over ->text */
+	if (unlikely(pc->busy)) {
+		pc->dropped++;
+		return 0;
+	}
+	pc->busy = 1;
+
+	len = vscnprintf(pc->text, sizeof(pc->text), fmt, args);
+	printk_pcpu_store(pc, len, local_clock());
+
+	pc->busy = 0;
+	__this_cpu_or(printk_pending, PRINTK_PENDING_OUTPUT);
+	return len;
+}
+
+static struct printk_rec *printk_pcpu_peek(struct printk_pcpu *pc)
+{
+	unsigned long head = ACCESS_ONCE(pc->head);
+	struct printk_rec *rec;
+	unsigned int off;
+
+	/* read ->head before the records it covers */
+	smp_rmb();
+
+	while (pc->tail != head) {
+		off = pc->tail & PRINTK_PCPU_MASK;
+		rec = (struct printk_rec *)(pc->buf + off);
+		if (PRINTK_PCPU_SIZE - off >= sizeof(*rec) && rec->size)
+			return rec;
+		pc->tail += PRINTK_PCPU_SIZE - off;
+	}
+	return NULL;
+}
+
+/*
+ * Move everything queued in the per-cpu buffers so far into log_buf,
+ * oldest first.  Records queued while this runs are left for the next
+ * call so that a printk() storm cannot keep us here forever.
+ *
+ * Called with logbuf_lock held.
+ */
+static void printk_pcpu_drain(void)
+{
+	unsigned long limit = atomic_long_read(&printk_seq);
+	struct printk_pcpu *pc, *next;
+	struct printk_rec *rec, *oldest;
+	unsigned long dropped;
+	int cpu;
+
+	if (!printk_pcpu_enabled)
+		return;
+
+	for (;;) {
+		next = NULL;
+		oldest = NULL;
+		for_each_possible_cpu(cpu) {
+			pc = &per_cpu(printk_pcpu, cpu);
+			rec = printk_pcpu_peek(pc);
+			if (!rec)
+				continue;
+			if (!oldest || (long)(rec->seq - oldest->seq) < 0) {
+				next = pc;
+				oldest = rec;
+			}
+		}
+		if (!oldest || (long)(oldest->seq - limit) > 0)
+			break;
+
+		log_store(oldest->text, oldest->ts);
+
+		/* done reading the record before handing its space back */
+		smp_mb();
+		next->tail += oldest->size;
+	}
+
+	for_each_possible_cpu(cpu) {
+		pc = &per_cpu(printk_pcpu, cpu);
+		dropped = ACCESS_ONCE(pc->dropped);
+		if (dropped == pc->dropped_seen)
+			continue;
+		snprintf(printk_buf, sizeof(printk_buf),
+			 KERN_WARNING "printk: %lu messages dropped on cpu%d\n",
+			 dropped - pc->dropped_seen, cpu);
+		log_store(printk_buf, local_clock());
+		pc->dropped_seen = dropped;
+	}
+}
+
+static bool printk_pcpu_pending(void)
+{
+	struct printk_pcpu *pc;
+	int cpu;
+
+	for_each_possible_cpu(cpu) {
+		pc = &per_cpu(printk_pcpu, cpu);
+		if (ACCESS_ONCE(pc->head) != pc->tail ||
+		    ACCESS_ONCE(pc->dropped) != pc->dropped_seen)
+			return true;
+	}
+	return false;
+}
+
+/*
+ * Print synchronously while the system goes down, so that the last
+ * messages make it out even if kprintkd never runs again.
+ */
+static inline bool printk_pcpu_usable(void)
+{
+	return printk_pcpu_enabled && !oops_in_progress &&
+		system_state == SYSTEM_RUNNING;
+}
+
+static int printk_kthread_fn(void *unused)
+{
+	unsigned long flags;
+
+	while (!kthread_should_stop()) {
+		set_current_state(TASK_INTERRUPTIBLE);
+		if (!printk_pcpu_pending())
+			schedule();
+		__set_current_state(TASK_RUNNING);
+
+		spin_lock_irqsave(&logbuf_lock, flags);
+		printk_pcpu_drain();
+		spin_unlock_irqrestore(&logbuf_lock, flags);
+
+		console_lock();
+		console_unlock();
+	}
+	return 0;
+}
+
+static int __init printk_pcpu_init(void)
+{
+	struct task_struct *p;
+
+	p = kthread_run(printk_kthread_fn, NULL, "kprintkd");
+	if (IS_ERR(p)) {
+		printk(KERN_ERR "printk: failed to start kprintkd, "
+		       "printing synchronously\n");
+		return PTR_ERR(p);
+	}
+	printk_kthread = p;
+	smp_wmb();
+	printk_pcpu_enabled = 1;
+	return 0;
+}
+early_initcall(printk_pcpu_init);
+#else
+static inline void printk_pcpu_drain(void) {}
+static inline bool printk_pcpu_usable(void) { return false; }
+static inline int vprintk_pcpu(const char *fmt, va_list args) { return 0; }
+#endif /* CONFIG_PRINTK_PERCPU */
+
+asmlinkage int vprintk(const char *fmt, va_list args)
+{
+	int printed_len = 0;
+	unsigned long flags;
+	int this_cpu;
+
+	boot_delay_msec();
+	printk_delay();
+
+	preempt_disable();
+	/* This stops the holder of console_sem just where we want him */
+	raw_local_irq_save(flags);
+	this_cpu = smp_processor_id();
+
+	if (printk_pcpu_usable()) {
+		printed_len = vprintk_pcpu(fmt, args);
+		goto out_restore_irqs;
+	}
+
+	/*
+	 * Ouch, printk recursed into itself!
+	 */
+	if (unlikely(printk_cpu == this_cpu)) {
+		/*
+		 * If a crash is occurring during printk() on this CPU,
+		 * then try to get the crash message out but make sure
+		 * we can't deadlock. Otherwise just return to avoid the
+		 * recursion and return - but flag the recursion so that
+		 * it can be printed at the next appropriate moment:
+		 */
+		if (!oops_in_progress) {
+			recursion_bug = 1;
+			goto out_restore_irqs;
+		}
+		zap_locks();
+	}
+
+	lockdep_off();
+	spin_lock(&logbuf_lock);
+	printk_cpu = this_cpu;
+
+	/* anything still queued per cpu is older than this message */
+	printk_pcpu_drain();
+
+	if (recursion_bug) {
+		recursion_bug = 0;
+		strcpy(printk_buf, recursion_bug_msg);
+		printed_len = strlen(recursion_bug_msg);
+	}
+	/* Emit the output into the temporary buffer */
+	printed_len += vscnprintf(printk_buf + printed_len,
+				  sizeof(printk_buf) - printed_len, fmt, args);
+
+	printed_len += log_store(printk_buf, cpu_clock(printk_cpu));
+
 	/*
 	 * Try to acquire and then immediately release the
 	 * console semaphore. The release will do all the
@@ -1293,13 +1562,17 @@ int is_console_locked(void)
 	return console_locked;
 }
 
-static DEFINE_PER_CPU(int, printk_pending);
-
 void printk_tick(void)
 {
 	if (__this_cpu_read(printk_pending)) {
-		__this_cpu_write(printk_pending, 0);
-		wake_up_interruptible(&log_wait);
+		int pending = __this_cpu_xchg(printk_pending, 0);
+
+		if (pending & PRINTK_PENDING_WAKEUP)
+			wake_up_interruptible(&log_wait);
+#ifdef CONFIG_PRINTK_PERCPU
+		if (pending & PRINTK_PENDING_OUTPUT)
+			wake_up_process(printk_kthread);
+#endif
 	}
 }
 
@@ -1313,7 +1586,7 @@ int printk_needs_cpu(int cpu)
 void wake_up_klogd(void)
 {
 	if (waitqueue_active(&log_wait))
-		this_cpu_write(printk_pending, 1);
+		this_cpu_or(printk_pending, PRINTK_PENDING_WAKEUP);
 }
 
 /**
@@ -1804,6 +2077,7 @@ void kmsg_dump(enum kmsg_dump_reason reason)
 	   there's not a lot we can do about that. The new messages
 	   will overwrite the start of what we dump. */
 	spin_lock_irqsave(&logbuf_lock, flags);
+	printk_pcpu_drain();
 	end = log_end & LOG_BUF_MASK;
 	chars = logged_chars;
 	spin_unlock_irqrestore(&logbuf_lock, flags);
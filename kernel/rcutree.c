@@ -50,6 +50,7 @@
 #include <linux/wait.h>
 #include <linux/kthread.h>
 #include <linux/prefetch.h>
+#include <linux/hash.h>
 
 #include "rcutree.h"
 
@@ -935,6 +936,8 @@ static void rcu_report_qs_rsp(struct rcu_state *rsp, unsigned long flags)
 	gp_duration = jiffies - rsp->gp_start;
 	if (gp_duration > rsp->gp_max)
 		rsp->gp_max = gp_duration;
+	rsp->gp_total += gp_duration;
+	rsp->n_gp++;
 	rsp->completed = rsp->gpnum;
 	rsp->signaled = RCU_GP_IDLE;
 	rcu_start_gp(rsp, flags);  /* releases root node's rnp->lock. */
@@ -1212,6 +1215,15 @@ static void rcu_do_batch(struct rcu_state *rsp, struct rcu_data *rdp)
 			rdp->nxttail[count] = &rdp->nxtlist;
 	local_irq_restore(flags);
 
+	/* Offloaded CPUs leave invoking them to their rcuo kthread. */
+	if (rcu_nocb_cpu(rdp->cpu)) {
+		count = rcu_nocb_enqueue(rdp->cpu, list, tail);
+		list = NULL;
+		local_irq_save(flags);
+		rdp->qlen -= count;
+		goto done;
+	}
+
 	/* Invoke callbacks. */
 	count = 0;
 	while (list) {
@@ -1238,7 +1250,7 @@ static void rcu_do_batch(struct rcu_state *rsp, struct rcu_data *rdp)
 			else
 				break;
 	}
-
+done:
 	/* Reinstate batch limit if we have worked down the excess. */
 	if (rdp->blimit == LONG_MAX && rdp->qlen <= qlowmark)
 		rdp->blimit = blimit;
@@ -1531,6 +1543,8 @@ __call_rcu(struct rcu_head *head, void (*func)(struct rcu_head *rcu),
 	*rdp->nxttail[RCU_NEXT_TAIL] = head;
 	rdp->nxttail[RCU_NEXT_TAIL] = &head->next;
 	rdp->qlen++;
+	if (rdp->qlen > rdp->qlen_max)
+		rdp->qlen_max = rdp->qlen;
 
 	/* If interrupts were disabled, don't dive into RCU core. */
 	if (irqs_disabled_flags(flags)) {
@@ -1590,6 +1604,94 @@ void call_rcu_bh(struct rcu_head *head, void (*func)(struct rcu_head *rcu))
 }
 EXPORT_SYMBOL_GPL(call_rcu_bh);
 
+#ifdef CONFIG_RCU_TRACE
+
+struct rcu_sync_caller rcu_sync_callers[RCU_SYNC_CALLERS];
+unsigned long rcu_sync_callers_dropped;
+unsigned long rcu_sync_cond_skipped;
+DEFINE_SPINLOCK(rcu_sync_callers_lock);
+
+/* Charge a wait that started at @start to the call site @ip. */
+static void rcu_sync_account(unsigned long ip, u64 start)
+{
+	u64 delta = local_clock() - start;
+	unsigned long i = hash_long(ip, RCU_SYNC_CALLERS_BITS);
+	struct rcu_sync_caller *rsc;
+	unsigned long flags;
+	int probe;
+
+	spin_lock_irqsave(&rcu_sync_callers_lock, flags);
+	for (probe = 0; probe < RCU_SYNC_CALLERS; probe++) {
+		rsc = &rcu_sync_callers[i];
+		if (!rsc->ip)
+			rsc->ip = ip;
+		if (rsc->ip == ip) {
+			rsc->count++;
+			rsc->total_ns += delta;
+			if (delta > rsc->max_ns)
+				rsc->max_ns = delta;
+			break;
+		}
+		i = (i + 1) & (RCU_SYNC_CALLERS - 1);
+	}
+	if (probe == RCU_SYNC_CALLERS)
+		rcu_sync_callers_dropped++;
+	spin_unlock_irqrestore(&rcu_sync_callers_lock, flags);
+}
+
+static void rcu_sync_cond_skip(void)
+{
+	unsigned long flags;
+
+	spin_lock_irqsave(&rcu_sync_callers_lock, flags);
+	rcu_sync_cond_skipped++;
+	spin_unlock_irqrestore(&rcu_sync_callers_lock, flags);
+}
+
+static inline u64 rcu_sync_clock(void)
+{
+	return local_clock();
+}
+
+#else /* #ifdef CONFIG_RCU_TRACE */
+
+static inline void rcu_sync_account(unsigned long ip, u64 start)
+{
+}
+
+static inline void rcu_sync_cond_skip(void)
+{
+}
+
+static inline u64 rcu_sync_clock(void)
+{
+	return 0;
+}
+
+#endif /* #else #ifdef CONFIG_RCU_TRACE */
+
+/*
+ * Queue a callback with @crf and wait for it to be invoked, charging the
+ * wait to the caller at @ip.  Concurrent waiters share grace periods
+ * because their callbacks are batched like any others.
+ */
+static void rcu_wait_gp(void (*crf)(struct rcu_head *head,
+				    void (*func)(struct rcu_head *head)),
+			unsigned long ip)
+{
+	struct rcu_synchronize rcu;
+	u64 start = rcu_sync_clock();
+
+	init_rcu_head_on_stack(&rcu.head);
+	init_completion(&rcu.completion);
+	/* Will wake me after RCU finished. */
+	crf(&rcu.head, wakeme_after_rcu);
+	/* Wait for it. */
+	wait_for_completion(&rcu.completion);
+	destroy_rcu_head_on_stack(&rcu.head);
+	rcu_sync_account(ip, start);
+}
+
 /**
  * synchronize_sched - wait until an rcu-sched grace period has elapsed.
  *
@@ -1615,18 +1717,9 @@ EXPORT_SYMBOL_GPL(call_rcu_bh);
  */
 void synchronize_sched(void)
 {
-	struct rcu_synchronize rcu;
-
 	if (rcu_blocking_is_gp())
 		return;
-
-	init_rcu_head_on_stack(&rcu.head);
-	init_completion(&rcu.completion);
-	/* Will wake me after RCU finished. */
-	call_rcu_sched(&rcu.head, wakeme_after_rcu);
-	/* Wait for it. */
-	wait_for_completion(&rcu.completion);
-	destroy_rcu_head_on_stack(&rcu.head);
+	rcu_wait_gp(call_rcu_sched, _RET_IP_);
 }
 EXPORT_SYMBOL_GPL(synchronize_sched);
 
@@ -1641,21 +1734,68 @@ EXPORT_SYMBOL_GPL(synchronize_sched);
  */
 void synchronize_rcu_bh(void)
 {
-	struct rcu_synchronize rcu;
-
 	if (rcu_blocking_is_gp())
 		return;
-
-	init_rcu_head_on_stack(&rcu.head);
-	init_completion(&rcu.completion);
-	/* Will wake me after RCU finished. */
-	call_rcu_bh(&rcu.head, wakeme_after_rcu);
-	/* Wait for it. */
-	wait_for_completion(&rcu.completion);
-	destroy_rcu_head_on_stack(&rcu.head);
+	rcu_wait_gp(call_rcu_bh, _RET_IP_);
 }
 EXPORT_SYMBOL_GPL(synchronize_rcu_bh);
 
+/**
+ * get_state_synchronize_rcu - snapshot the RCU grace-period state
+ *
+ * Returns a cookie to be passed to cond_synchronize_rcu() later.  Any
+ * grace period that starts after this call and completes before the
+ * cond_synchronize_rcu() satisfies it.  This lets a caller that used to
+ * call synchronize_rcu() right after each update instead take a
+ * snapshot, do other work, and only wait if no other user of RCU has
+ * driven a full grace period in the meantime.
+ */
+unsigned long get_state_synchronize_rcu(void)
+{
+	/* Order the caller's updates before the snapshot. */
+	smp_mb();
+	return ACCESS_ONCE(rcu_state->gpnum);
+}
+EXPORT_SYMBOL_GPL(get_state_synchronize_rcu);
+
+/*
+ * The same shortcuts synchronize_rcu() takes: with preemptible RCU a
+ * preempted reader can still be in its critical section even when only
+ * one CPU is online, so only the early boot case may skip the wait.
+ */
+static inline bool cond_synchronize_needs_gp(void)
+{
+#ifdef CONFIG_TREE_PREEMPT_RCU
+	return rcu_scheduler_active;
+#else
+	return !rcu_blocking_is_gp();
+#endif
+}
+
+/**
+ * cond_synchronize_rcu - wait for a grace period if one is still needed
+ * @oldstate: return value of an earlier get_state_synchronize_rcu()
+ *
+ * Return immediately if a full grace period has elapsed since @oldstate
+ * was taken, otherwise wait in synchronize_rcu().  Either way, all RCU
+ * read-side critical sections that were running when @oldstate was
+ * taken have completed on return.
+ */
+void cond_synchronize_rcu(unsigned long oldstate)
+{
+	unsigned long newstate;
+
+	newstate = ACCESS_ONCE(rcu_state->completed);
+	/* Order the snapshot before the caller's subsequent frees. */
+	smp_mb();
+	if (ULONG_CMP_GE(oldstate, newstate) && cond_synchronize_needs_gp()) {
+		rcu_wait_gp(call_rcu, _RET_IP_);
+		return;
+	}
+	rcu_sync_cond_skip();
+}
+EXPORT_SYMBOL_GPL(cond_synchronize_rcu);
+
 /*
  * Check to see if there is any immediate RCU-related work to be done
  * by the current CPU, for the specified type of RCU, returning 1 if so.
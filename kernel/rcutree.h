@@ -265,6 +265,7 @@ struct rcu_data {
 	struct rcu_head *nxtlist;
 	struct rcu_head **nxttail[RCU_NEXT_SIZE];
 	long		qlen;		/* # of queued callbacks */
+	long		qlen_max;	/* high-water mark of qlen */
 	long		qlen_last_fqs_check;
 					/* qlen at last check for QS forcing */
 	unsigned long	n_cbs_invoked;	/* count of RCU cbs invoked. */
@@ -393,9 +394,55 @@ struct rcu_state {
 						/*  for CPU stalls. */
 	unsigned long gp_max;			/* Maximum GP duration in */
 						/*  jiffies. */
+	unsigned long gp_total;			/* Sum of GP durations and */
+	unsigned long n_gp;			/*  number of GPs, for the */
+						/*  average in rcugp. */
 	char *name;				/* Name of structure. */
 };
 
+#ifdef CONFIG_RCU_TRACE
+/*
+ * Time spent waiting in synchronize_sched(), synchronize_rcu_bh(),
+ * synchronize_rcu() and cond_synchronize_rcu(), per call site.
+ */
+#define RCU_SYNC_CALLERS_BITS	6
+#define RCU_SYNC_CALLERS	(1 << RCU_SYNC_CALLERS_BITS)
+
+struct rcu_sync_caller {
+	unsigned long ip;			/* Return address of caller. */
+	unsigned long count;			/* Number of waits. */
+	u64 total_ns;				/* Cumulative wait time. */
+	u64 max_ns;				/* Longest wait. */
+};
+
+extern struct rcu_sync_caller rcu_sync_callers[RCU_SYNC_CALLERS];
+extern unsigned long rcu_sync_callers_dropped;
+extern unsigned long rcu_sync_cond_skipped;
+extern spinlock_t rcu_sync_callers_lock;
+#endif /* #ifdef CONFIG_RCU_TRACE */
+
+#ifdef CONFIG_RCU_NOCB_CPU
+/*
+ * Per-CPU queue of callbacks whose grace period has ended, waiting to be
+ * invoked by the CPU's rcuo kthread rather than by its RCU softirq.
+ * Shared by all RCU flavors.
+ */
+struct rcu_nocb {
+	raw_spinlock_t lock;
+	struct rcu_head *head;			/* L: ready callbacks */
+	struct rcu_head **tail;			/* L */
+	long qlen;				/* L: # of queued callbacks */
+	long qlen_max;				/* L: high-water mark */
+	unsigned long n_cbs_queued;		/* L: handed over */
+	unsigned long n_cbs_invoked;		/* L: invoked by kthread */
+	unsigned long n_wakeups;		/* L: kthread wakeups */
+	struct task_struct *kthread;		/* NULL: not offloaded */
+	wait_queue_head_t wq;
+};
+
+DECLARE_PER_CPU(struct rcu_nocb, rcu_nocb);
+#endif /* #ifdef CONFIG_RCU_NOCB_CPU */
+
 /* Return values for rcu_preempt_offline_tasks(). */
 
 #define RCU_OFL_TASKS_NORM_GP	0x1		/* Tasks blocking normal */
@@ -466,5 +513,8 @@ static void rcu_yield(void (*f)(unsigned long), unsigned long arg);
 #endif /* #ifdef CONFIG_RCU_BOOST */
 static void rcu_cpu_kthread_setrt(int cpu, int to_rt);
 static void __cpuinit rcu_prepare_kthreads(int cpu);
+static bool rcu_nocb_cpu(int cpu);
+static long rcu_nocb_enqueue(int cpu, struct rcu_head *list,
+			     struct rcu_head **tail);
 
 #endif /* #ifndef RCU_TREE_NONCORE */
@@ -656,18 +656,9 @@ EXPORT_SYMBOL_GPL(call_rcu);
  */
 void synchronize_rcu(void)
 {
-	struct rcu_synchronize rcu;
-
 	if (!rcu_scheduler_active)
 		return;
-
-	init_rcu_head_on_stack(&rcu.head);
-	init_completion(&rcu.completion);
-	/* Will wake me after RCU finished. */
-	call_rcu(&rcu.head, wakeme_after_rcu);
-	/* Wait for it. */
-	wait_for_completion(&rcu.completion);
-	destroy_rcu_head_on_stack(&rcu.head);
+	rcu_wait_gp(call_rcu, _RET_IP_);
 }
 EXPORT_SYMBOL_GPL(synchronize_rcu);
 
@@ -2008,3 +1999,158 @@ static void rcu_needs_cpu_flush(void)
 }
 
 #endif /* #else #if !defined(CONFIG_RCU_FAST_NO_HZ) */
+
+#ifdef CONFIG_RCU_NOCB_CPU
+
+/*
+ * Callback offloading.  The CPUs given by rcu_nocbs= still detect
+ * grace periods in their RCU softirq, but the callbacks whose grace
+ * period has ended are handed to a per-CPU rcuo kthread instead of
+ * being invoked there.  The kthreads are allowed to run on any CPU that
+ * is not offloaded, and can be moved elsewhere with sched_setaffinity().
+ */
+static DECLARE_BITMAP(rcu_nocb_bits, CONFIG_NR_CPUS);
+#define rcu_nocb_mask to_cpumask(rcu_nocb_bits)
+
+DEFINE_PER_CPU(struct rcu_nocb, rcu_nocb);
+
+static int __init rcu_nocb_setup(char *str)
+{
+	if (cpulist_parse(str, rcu_nocb_mask) < 0) {
+		printk(KERN_WARNING "rcu_nocbs= bad CPU list, ignored\n");
+		cpumask_clear(rcu_nocb_mask);
+	}
+	return 1;
+}
+__setup("rcu_nocbs=", rcu_nocb_setup);
+
+/*
+ * Is @cpu's callback invocation offloaded?  False until its kthread
+ * exists, so early callbacks are invoked the usual way.
+ */
+static bool rcu_nocb_cpu(int cpu)
+{
+	return ACCESS_ONCE(per_cpu(rcu_nocb, cpu).kthread) != NULL;
+}
+
+/*
+ * Append the ready callbacks [@list, *@tail) to @cpu's offload queue
+ * and wake its kthread.  Returns the number of callbacks moved.
+ */
+static long rcu_nocb_enqueue(int cpu, struct rcu_head *list,
+			     struct rcu_head **tail)
+{
+	struct rcu_nocb *rnc = &per_cpu(rcu_nocb, cpu);
+	struct rcu_head *rhp;
+	unsigned long flags;
+	long count = 0;
+
+	for (rhp = list; rhp; rhp = rhp->next)
+		count++;
+
+	raw_spin_lock_irqsave(&rnc->lock, flags);
+	*rnc->tail = list;
+	rnc->tail = tail;
+	rnc->qlen += count;
+	if (rnc->qlen > rnc->qlen_max)
+		rnc->qlen_max = rnc->qlen;
+	rnc->n_cbs_queued += count;
+	raw_spin_unlock_irqrestore(&rnc->lock, flags);
+
+	wake_up(&rnc->wq);
+	return count;
+}
+
+static int rcu_nocb_kthread(void *arg)
+{
+	struct rcu_nocb *rnc = arg;
+	struct rcu_head *list, *next;
+	unsigned long flags;
+	long count;
+
+	for (;;) {
+		wait_event_interruptible(rnc->wq, ACCESS_ONCE(rnc->head));
+
+		raw_spin_lock_irqsave(&rnc->lock, flags);
+		list = rnc->head;
+		rnc->head = NULL;
+		rnc->tail = &rnc->head;
+		rnc->n_wakeups++;
+		raw_spin_unlock_irqrestore(&rnc->lock, flags);
+
+		/* Callbacks expect to run with bottom halves disabled. */
+		count = 0;
+		while (list) {
+			next = list->next;
+			prefetch(next);
+			local_bh_disable();
+			debug_rcu_head_unqueue(list);
+			__rcu_reclaim(list);
+			local_bh_enable();
+			list = next;
+			count++;
+			cond_resched();
+		}
+
+		raw_spin_lock_irqsave(&rnc->lock, flags);
+		rnc->qlen -= count;
+		rnc->n_cbs_invoked += count;
+		raw_spin_unlock_irqrestore(&rnc->lock, flags);
+	}
+	return 0;
+}
+
+static int __init rcu_spawn_nocb_kthreads(void)
+{
+	struct task_struct *t;
+	cpumask_var_t cm;
+	char buf[64];
+	int cpu;
+
+	cpumask_and(rcu_nocb_mask, rcu_nocb_mask, cpu_possible_mask);
+	if (cpumask_empty(rcu_nocb_mask))
+		return 0;
+	if (!zalloc_cpumask_var(&cm, GFP_KERNEL))
+		return -ENOMEM;
+	cpumask_andnot(cm, cpu_possible_mask, rcu_nocb_mask);
+	if (cpumask_empty(cm))
+		cpumask_copy(cm, cpu_possible_mask);
+
+	for_each_cpu(cpu, rcu_nocb_mask) {
+		struct rcu_nocb *rnc = &per_cpu(rcu_nocb, cpu);
+
+		raw_spin_lock_init(&rnc->lock);
+		rnc->tail = &rnc->head;
+		init_waitqueue_head(&rnc->wq);
+		t = kthread_create(rcu_nocb_kthread, rnc, "rcuo%d", cpu);
+		if (IS_ERR(t)) {
+			printk(KERN_ERR "rcu: cannot offload CPU %d\n", cpu);
+			continue;
+		}
+		set_cpus_allowed_ptr(t, cm);
+		wake_up_process(t);
+		smp_wmb(); /* Initialize rnc before publishing ->kthread. */
+		rnc->kthread = t;
+	}
+	cpulist_scnprintf(buf, sizeof(buf), rcu_nocb_mask);
+	printk(KERN_INFO "rcu: offloading callbacks from CPUs %s\n", buf);
+
+	free_cpumask_var(cm);
+	return 0;
+}
+early_initcall(rcu_spawn_nocb_kthreads);
+
+#else /* #ifdef CONFIG_RCU_NOCB_CPU */
+
+static bool rcu_nocb_cpu(int cpu)
+{
+	return false;
+}
+
+static long rcu_nocb_enqueue(int cpu, struct rcu_head *list,
+			     struct rcu_head **tail)
+{
+	return 0;
+}
+
+#endif /* #else #ifdef CONFIG_RCU_NOCB_CPU */
@@ -42,6 +42,8 @@
 #include <linux/mutex.h>
 #include <linux/debugfs.h>
 #include <linux/seq_file.h>
+#include <linux/slab.h>
+#include <linux/sort.h>
 
 #define RCU_TREE_NONCORE
 #include "rcutree.h"
@@ -337,6 +339,7 @@ static void show_one_rcugp(struct seq_file *m, struct rcu_state *rsp)
 	unsigned long gpnum;
 	unsigned long gpage;
 	unsigned long gpmax;
+	unsigned long gpavg;
 	struct rcu_node *rnp = &rsp->node[0];
 
 	raw_spin_lock_irqsave(&rnp->lock, flags);
@@ -347,9 +350,11 @@ static void show_one_rcugp(struct seq_file *m, struct rcu_state *rsp)
 	else
 		gpage = jiffies - rsp->gp_start;
 	gpmax = rsp->gp_max;
+	gpavg = rsp->n_gp ? rsp->gp_total / rsp->n_gp : 0;
 	raw_spin_unlock_irqrestore(&rnp->lock, flags);
-	seq_printf(m, "%s: completed=%ld  gpnum=%lu  age=%ld  max=%ld\n",
-		   rsp->name, completed, gpnum, gpage, gpmax);
+	seq_printf(m, "%s: completed=%ld  gpnum=%lu  age=%ld  max=%ld  "
+		   "avg=%ld\n",
+		   rsp->name, completed, gpnum, gpage, gpmax, gpavg);
 }
 
 static int show_rcugp(struct seq_file *m, void *unused)
@@ -375,6 +380,111 @@ static const struct file_operations rcugp_fops = {
 	.release = single_release,
 };
 
+static void print_one_rcu_qlen(struct seq_file *m, struct rcu_state *rsp,
+			       int cpu)
+{
+	struct rcu_data *rdp = per_cpu_ptr(rsp->rda, cpu);
+
+	seq_printf(m, " %s=%ld/%ld", rsp->name, rdp->qlen, rdp->qlen_max);
+}
+
+static int show_rcucbs(struct seq_file *m, void *unused)
+{
+	int cpu;
+
+	for_each_possible_cpu(cpu) {
+		seq_printf(m, "%3d%c", cpu, cpu_is_offline(cpu) ? '!' : ' ');
+#ifdef CONFIG_TREE_PREEMPT_RCU
+		print_one_rcu_qlen(m, &rcu_preempt_state, cpu);
+#endif /* #ifdef CONFIG_TREE_PREEMPT_RCU */
+		print_one_rcu_qlen(m, &rcu_sched_state, cpu);
+		print_one_rcu_qlen(m, &rcu_bh_state, cpu);
+#ifdef CONFIG_RCU_NOCB_CPU
+		{
+			struct rcu_nocb *rnc = &per_cpu(rcu_nocb, cpu);
+
+			if (rnc->kthread)
+				seq_printf(m, " nocb=%ld/%ld q=%lu i=%lu w=%lu",
+					   rnc->qlen, rnc->qlen_max,
+					   rnc->n_cbs_queued,
+					   rnc->n_cbs_invoked,
+					   rnc->n_wakeups);
+		}
+#endif /* #ifdef CONFIG_RCU_NOCB_CPU */
+		seq_putc(m, '\n');
+	}
+	return 0;
+}
+
+static int rcucbs_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, show_rcucbs, NULL);
+}
+
+static const struct file_operations rcucbs_fops = {
+	.owner = THIS_MODULE,
+	.open = rcucbs_open,
+	.read = seq_read,
+	.llseek = seq_lseek,
+	.release = single_release,
+};
+
+static int rcu_sync_caller_cmp(const void *a, const void *b)
+{
+	const struct rcu_sync_caller *x = a, *y = b;
+
+	if (x->total_ns == y->total_ns)
+		return 0;
+	return x->total_ns < y->total_ns ? 1 : -1;
+}
+
+static int show_rcusync(struct seq_file *m, void *unused)
+{
+	struct rcu_sync_caller *snap;
+	unsigned long dropped, skipped;
+	int i;
+
+	snap = kmalloc(sizeof(rcu_sync_callers), GFP_KERNEL);
+	if (!snap)
+		return -ENOMEM;
+
+	spin_lock_irq(&rcu_sync_callers_lock);
+	memcpy(snap, rcu_sync_callers, sizeof(rcu_sync_callers));
+	dropped = rcu_sync_callers_dropped;
+	skipped = rcu_sync_cond_skipped;
+	spin_unlock_irq(&rcu_sync_callers_lock);
+
+	sort(snap, RCU_SYNC_CALLERS, sizeof(*snap), rcu_sync_caller_cmp, NULL);
+
+	seq_printf(m, "cond_skipped=%lu dropped=%lu\n", skipped, dropped);
+	seq_printf(m, "%10s %12s %10s %10s  caller\n",
+		   "count", "total_us", "avg_us", "max_us");
+	for (i = 0; i < RCU_SYNC_CALLERS && snap[i].ip; i++)
+		seq_printf(m, "%10lu %12llu %10llu %10llu  %pS\n",
+			   snap[i].count,
+			   div_u64(snap[i].total_ns, NSEC_PER_USEC),
+			   div_u64(div_u64(snap[i].total_ns, snap[i].count),
+				   NSEC_PER_USEC),
+			   div_u64(snap[i].max_ns, NSEC_PER_USEC),
+			   (void *)snap[i].ip);
+
+	kfree(snap);
+	return 0;
+}
+
+static int rcusync_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, show_rcusync, NULL);
+}
+
+static const struct file_operations rcusync_fops = {
+	.owner = THIS_MODULE,
+	.open = rcusync_open,
+	.read = seq_read,
+	.llseek = seq_lseek,
+	.release = single_release,
+};
+
 static void print_one_rcu_pending(struct seq_file *m, struct rcu_data *rdp)
 {
 	seq_printf(m, "%3d%cnp=%ld "
@@ -481,6 +591,16 @@ static int __init rcutree_trace_init(void)
 	if (!retval)
 		goto free_out;
 
+	retval = debugfs_create_file("rcucbs", 0444, rcudir,
+						NULL, &rcucbs_fops);
+	if (!retval)
+		goto free_out;
+
+	retval = debugfs_create_file("rcusync", 0444, rcudir,
+						NULL, &rcusync_fops);
+	if (!retval)
+		goto free_out;
+
 	retval = debugfs_create_file("rcuhier", 0444, rcudir,
 						NULL, &rcuhier_fops);
 	if (!retval)
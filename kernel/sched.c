@@ -194,10 +194,28 @@ static inline int rt_bandwidth_enabled(void)
 	return sysctl_sched_rt_runtime >= 0;
 }
 
-static void start_rt_bandwidth(struct rt_bandwidth *rt_b)
+static void start_bandwidth_timer(struct hrtimer *period_timer, ktime_t period)
 {
-	ktime_t now;
+	unsigned long delta;
+	ktime_t soft, hard, now;
 
+	for (;;) {
+		if (hrtimer_active(period_timer))
+			break;
+
+		now = hrtimer_cb_get_time(period_timer);
+		hrtimer_forward(period_timer, now, period);
+
+		soft = hrtimer_get_softexpires(period_timer);
+		hard = hrtimer_get_expires(period_timer);
+		delta = ktime_to_ns(ktime_sub(hard, soft));
+		__hrtimer_start_range_ns(period_timer, soft, delta,
+					 HRTIMER_MODE_ABS_PINNED, 0);
+	}
+}
+
+static void start_rt_bandwidth(struct rt_bandwidth *rt_b)
+{
 	if (!rt_bandwidth_enabled() || rt_b->rt_runtime == RUNTIME_INF)
 		return;
 
@@ -205,22 +223,7 @@ static void start_rt_bandwidth(struct rt_bandwidth *rt_b)
 		return;
 
 	raw_spin_lock(&rt_b->rt_runtime_lock);
-	for (;;) {
-		unsigned long delta;
-		ktime_t soft, hard;
-
-		if (hrtimer_active(&rt_b->rt_period_timer))
-			break;
-
-		now = hrtimer_cb_get_time(&rt_b->rt_period_timer);
-		hrtimer_forward(&rt_b->rt_period_timer, now, rt_b->rt_period);
-
-		soft = hrtimer_get_softexpires(&rt_b->rt_period_timer);
-		hard = hrtimer_get_expires(&rt_b->rt_period_timer);
-		delta = ktime_to_ns(ktime_sub(hard, soft));
-		__hrtimer_start_range_ns(&rt_b->rt_period_timer, soft, delta,
-				HRTIMER_MODE_ABS_PINNED, 0);
-	}
+	start_bandwidth_timer(&rt_b->rt_period_timer, rt_b->rt_period);
 	raw_spin_unlock(&rt_b->rt_runtime_lock);
 }
 
@@ -245,6 +248,24 @@ struct cfs_rq;
 
 static LIST_HEAD(task_groups);
 
+struct cfs_bandwidth {
+#ifdef CONFIG_CFS_BANDWIDTH
+	raw_spinlock_t lock;
+	ktime_t period;
+	u64 quota, runtime;
+	s64 hierarchal_quota;
+	u64 runtime_expires;
+
+	int idle, timer_active;
+	struct hrtimer period_timer;
+	struct list_head throttled_cfs_rq;
+
+	/* statistics */
+	int nr_periods, nr_throttled;
+	u64 throttled_time;
+#endif
+};
+
 /* task group related information */
 struct task_group {
 	struct cgroup_subsys_state css;
@@ -276,6 +297,8 @@ struct task_group {
 #ifdef CONFIG_SCHED_AUTOGROUP
 	struct autogroup *autogroup;
 #endif
+
+	struct cfs_bandwidth cfs_bandwidth;
 };
 
 /* task_group_lock serializes the addition/removal of task groups */
@@ -309,7 +332,7 @@ struct task_group root_task_group;
 /* CFS-related fields in a runqueue */
 struct cfs_rq {
 	struct load_weight load;
-	unsigned long nr_running;
+	unsigned long nr_running, h_nr_running;
 
 	u64 exec_clock;
 	u64 min_vruntime;
@@ -375,9 +398,107 @@ struct cfs_rq {
 
 	unsigned long load_contribution;
 #endif
+#ifdef CONFIG_CFS_BANDWIDTH
+	int runtime_enabled;
+	u64 runtime_expires;
+	s64 runtime_remaining;
+
+	u64 throttled_timestamp;
+	int throttled, throttle_count;
+	struct list_head throttled_list;
+#endif
 #endif
 };
 
+#ifdef CONFIG_FAIR_GROUP_SCHED
+#ifdef CONFIG_CFS_BANDWIDTH
+static inline struct cfs_bandwidth *tg_cfs_bandwidth(struct task_group *tg)
+{
+	return &tg->cfs_bandwidth;
+}
+
+static inline u64 default_cfs_period(void);
+static int do_sched_cfs_period_timer(struct cfs_bandwidth *cfs_b, int overrun);
+
+static enum hrtimer_restart sched_cfs_period_timer(struct hrtimer *timer)
+{
+	struct cfs_bandwidth *cfs_b =
+		container_of(timer, struct cfs_bandwidth, period_timer);
+	ktime_t now;
+	int overrun;
+	int idle = 0;
+
+	for (;;) {
+		now = hrtimer_cb_get_time(timer);
+		overrun = hrtimer_forward(timer, now, cfs_b->period);
+
+		if (!overrun)
+			break;
+
+		idle = do_sched_cfs_period_timer(cfs_b, overrun);
+	}
+
+	return idle ? HRTIMER_NORESTART : HRTIMER_RESTART;
+}
+
+static void init_cfs_bandwidth(struct cfs_bandwidth *cfs_b)
+{
+	raw_spin_lock_init(&cfs_b->lock);
+	cfs_b->runtime = 0;
+	cfs_b->quota = RUNTIME_INF;
+	cfs_b->period = ns_to_ktime(default_cfs_period());
+
+	INIT_LIST_HEAD(&cfs_b->throttled_cfs_rq);
+	hrtimer_init(&cfs_b->period_timer, CLOCK_MONOTONIC, HRTIMER_MODE_REL);
+	cfs_b->period_timer.function = sched_cfs_period_timer;
+}
+
+static void init_cfs_rq_runtime(struct cfs_rq *cfs_rq)
+{
+	cfs_rq->runtime_enabled = 0;
+	INIT_LIST_HEAD(&cfs_rq->throttled_list);
+}
+
+/* requires cfs_b->lock, may release to reprogram timer */
+static void __start_cfs_bandwidth(struct cfs_bandwidth *cfs_b)
+{
+	/*
+	 * The timer may be active because we're trying to set a new bandwidth
+	 * period or because we're racing with the tear-down path
+	 * (timer_active==0 becomes visible before the hrtimer call-back
+	 * terminates).  In either case we ensure that it's re-programmed
+	 */
+	while (unlikely(hrtimer_active(&cfs_b->period_timer))) {
+		raw_spin_unlock(&cfs_b->lock);
+		/* ensure cfs_b->lock is available while we wait */
+		hrtimer_cancel(&cfs_b->period_timer);
+
+		raw_spin_lock(&cfs_b->lock);
+		/* if someone else restarted the timer then we're done */
+		if (cfs_b->timer_active)
+			return;
+	}
+
+	cfs_b->timer_active = 1;
+	start_bandwidth_timer(&cfs_b->period_timer, cfs_b->period);
+}
+
+static void destroy_cfs_bandwidth(struct cfs_bandwidth *cfs_b)
+{
+	hrtimer_cancel(&cfs_b->period_timer);
+}
+#else
+static void init_cfs_rq_runtime(struct cfs_rq *cfs_rq) {}
+static void init_cfs_bandwidth(struct cfs_bandwidth *cfs_b) {}
+static void destroy_cfs_bandwidth(struct cfs_bandwidth *cfs_b) {}
+
+static inline struct cfs_bandwidth *tg_cfs_bandwidth(struct task_group *tg)
+{
+	return NULL;
+}
+#endif /* CONFIG_CFS_BANDWIDTH */
+#endif /* CONFIG_FAIR_GROUP_SCHED */
+
 /* Real-Time classes' related field in a runqueue: */
 struct rt_rq {
 	struct rt_prio_array active;
@@ -444,6 +565,23 @@ static struct root_domain def_root_domain;
 
 #endif /* CONFIG_SMP */
 
+#ifdef CONFIG_SCHEDSTATS
+/*
+ * Per-cpu log2 latency histograms.  Bucket 0 counts samples below
+ * 1024ns, bucket i samples in [2^(i-1), 2^i) units of 1024ns and the last
+ * bucket everything above.
+ */
+enum {
+	SCHED_HIST_WAKEUP,	/* wakeup until the task ran */
+	SCHED_HIST_PREEMPT,	/* preemption until the task ran again */
+	SCHED_HIST_SLICE,	/* time on the cpu per switch-in */
+	SCHED_HIST_NR,
+};
+
+#define SCHED_HIST_SHIFT	10
+#define SCHED_HIST_BUCKETS	24
+#endif
+
 /*
  * This is the main, per-CPU runqueue data structure.
  *
@@ -524,6 +662,9 @@ struct rq {
 	u64 age_stamp;
 	u64 idle_stamp;
 	u64 avg_idle;
+
+	/* exit latency of the cpuidle state we are in, 0 when running */
+	unsigned int idle_exit_latency;
 #endif
 
 #ifdef CONFIG_IRQ_TIME_ACCOUNTING
@@ -534,6 +675,18 @@ struct rq {
 	unsigned long calc_load_update;
 	long calc_load_active;
 
+	/* decayed utilization and nr_running, see sched_load_track_fold() */
+	u64 lt_stamp;
+	u64 lt_fold_stamp;
+	u64 lt_busy_sum;
+	u64 lt_nr_sum;
+	unsigned long lt_util;
+	unsigned long lt_nr_avg;
+#ifdef CONFIG_SMP
+	/* utilization pulled in by the current balance pass */
+	unsigned long lt_pulled;
+#endif
+
 #ifdef CONFIG_SCHED_HRTICK
 #ifdef CONFIG_SMP
 	int hrtick_csd_pending;
@@ -559,6 +712,9 @@ struct rq {
 	/* try_to_wake_up() stats */
 	unsigned int ttwu_count;
 	unsigned int ttwu_local;
+
+	/* latency histograms, see sched_hist_add() */
+	unsigned int sched_hist[SCHED_HIST_NR][SCHED_HIST_BUCKETS];
 #endif
 
 #ifdef CONFIG_SMP
@@ -1461,24 +1617,28 @@ static inline void dec_cpu_load(struct rq *rq, unsigned long load)
 	update_load_sub(&rq->load, load);
 }
 
-#if (defined(CONFIG_SMP) && defined(CONFIG_FAIR_GROUP_SCHED)) || defined(CONFIG_RT_GROUP_SCHED)
+#if (defined(CONFIG_SMP) && defined(CONFIG_FAIR_GROUP_SCHED)) || \
+	defined(CONFIG_RT_GROUP_SCHED) || defined(CONFIG_CFS_BANDWIDTH)
 typedef int (*tg_visitor)(struct task_group *, void *);
 
 /*
- * Iterate the full tree, calling @down when first entering a node and @up when
- * leaving it for the final time.
+ * Iterate task_group tree rooted at *from, calling @down when first entering a
+ * node and @up when leaving it for the final time.
+ *
+ * Caller must hold rcu_lock or sufficient equivalent.
  */
-static int walk_tg_tree(tg_visitor down, tg_visitor up, void *data)
+static int walk_tg_tree_from(struct task_group *from,
+			     tg_visitor down, tg_visitor up, void *data)
 {
 	struct task_group *parent, *child;
 	int ret;
 
-	rcu_read_lock();
-	parent = &root_task_group;
+	parent = from;
+
 down:
 	ret = (*down)(parent, data);
 	if (ret)
-		goto out_unlock;
+		goto out;
 	list_for_each_entry_rcu(child, &parent->children, siblings) {
 		parent = child;
 		goto down;
@@ -1487,14 +1647,27 @@ up:
 		continue;
 	}
 	ret = (*up)(parent, data);
-	if (ret)
-		goto out_unlock;
+	if (ret || parent == from)
+		goto out;
 
 	child = parent;
 	parent = parent->parent;
 	if (parent)
 		goto up;
-out_unlock:
+out:
+	return ret;
+}
+
+/*
+ * Iterate the full tree, calling @down when first entering a node and @up when
+ * leaving it for the final time.
+ */
+static int walk_tg_tree(tg_visitor down, tg_visitor up, void *data)
+{
+	int ret;
+
+	rcu_read_lock();
+	ret = walk_tg_tree_from(&root_task_group, down, up, data);
 	rcu_read_unlock();
 
 	return ret;
@@ -1777,13 +1950,225 @@ static const struct sched_class rt_sched_class;
 
 #include "sched_stats.h"
 
+/*
+ * Per-cpu load tracking.
+ *
+ * Between two scheduler ticks we integrate the time the runqueue was busy
+ * and nr_running over time, which costs an add and a multiply whenever
+ * nr_running changes. The tick folds the integrals into exponentially
+ * decayed averages, each elapsed tick period moving the average a quarter
+ * of the way towards the value observed over the window. Both averages use
+ * SCHED_LOAD_TRACK_SHIFT fixed point: lt_util is 0..SCHED_LOAD_TRACK_SCALE,
+ * lt_nr_avg is nr_running * SCHED_LOAD_TRACK_SCALE.
+ */
+#define LOAD_TRACK_DECAY_SHIFT	2
+#define LOAD_TRACK_MAX_PERIODS	32
+
+static inline void sched_load_track_account(struct rq *rq)
+{
+	u64 now = rq->clock;
+	u64 delta = now - rq->lt_stamp;
+
+	rq->lt_stamp = now;
+	if (rq->nr_running) {
+		rq->lt_busy_sum += delta;
+		rq->lt_nr_sum += delta * rq->nr_running;
+	}
+}
+
+static unsigned long
+sched_load_track_decay(unsigned long avg, unsigned long sample,
+		       unsigned long periods)
+{
+	if (periods > LOAD_TRACK_MAX_PERIODS)
+		return sample;
+
+	while (periods--) {
+		if (sample > avg)
+			avg += (sample - avg + (1UL << LOAD_TRACK_DECAY_SHIFT) - 1)
+				>> LOAD_TRACK_DECAY_SHIFT;
+		else
+			avg -= (avg - sample) >> LOAD_TRACK_DECAY_SHIFT;
+	}
+	return avg;
+}
+
+static void sched_load_track_fold(struct rq *rq)
+{
+	u64 window, util, nr;
+	unsigned long periods;
+
+	sched_load_track_account(rq);
+	window = rq->lt_stamp - rq->lt_fold_stamp;
+	if (window < TICK_NSEC / 2)
+		return;
+
+	util = div64_u64(rq->lt_busy_sum << SCHED_LOAD_TRACK_SHIFT, window);
+	nr = div64_u64(rq->lt_nr_sum << SCHED_LOAD_TRACK_SHIFT, window);
+	periods = div64_u64(window + TICK_NSEC / 2, TICK_NSEC);
+
+	rq->lt_util = sched_load_track_decay(rq->lt_util, util, periods);
+	rq->lt_nr_avg = sched_load_track_decay(rq->lt_nr_avg, nr, periods);
+	rq->lt_busy_sum = 0;
+	rq->lt_nr_sum = 0;
+	rq->lt_fold_stamp = rq->lt_stamp;
+
+	trace_sched_load_avg(cpu_of(rq), rq->lt_util, rq->lt_nr_avg);
+}
+
+/*
+ * A cpu in tickless idle does not fold, so readers decay its average
+ * themselves for the ticks it missed.
+ */
+static unsigned long
+sched_load_track_read(int cpu, unsigned long avg)
+{
+	struct rq *rq = cpu_rq(cpu);
+	u64 stale;
+
+	if (ACCESS_ONCE(rq->nr_running))
+		return avg;
+
+	stale = cpu_clock(cpu) - ACCESS_ONCE(rq->lt_fold_stamp);
+	if ((s64)stale < 2 * (s64)TICK_NSEC)
+		return avg;
+
+	return sched_load_track_decay(avg, 0, div64_u64(stale, TICK_NSEC) - 1);
+}
+
+/**
+ * sched_cpu_util - decayed fraction of time @cpu had runnable tasks
+ * @cpu: the cpu in question
+ *
+ * Returns a value between 0 and SCHED_LOAD_TRACK_SCALE.
+ */
+unsigned long sched_cpu_util(int cpu)
+{
+	return sched_load_track_read(cpu, ACCESS_ONCE(cpu_rq(cpu)->lt_util));
+}
+EXPORT_SYMBOL_GPL(sched_cpu_util);
+
+/**
+ * sched_cpu_nr_running_avg - decayed nr_running of @cpu
+ * @cpu: the cpu in question
+ *
+ * Returns the average scaled by SCHED_LOAD_TRACK_SCALE.
+ */
+unsigned long sched_cpu_nr_running_avg(int cpu)
+{
+	return sched_load_track_read(cpu, ACCESS_ONCE(cpu_rq(cpu)->lt_nr_avg));
+}
+EXPORT_SYMBOL_GPL(sched_cpu_nr_running_avg);
+
+/**
+ * sched_nr_running_avg - decayed nr_running summed over online cpus
+ *
+ * Returns the average scaled by SCHED_LOAD_TRACK_SCALE.
+ */
+unsigned long sched_nr_running_avg(void)
+{
+	unsigned long sum = 0;
+	int cpu;
+
+	for_each_online_cpu(cpu)
+		sum += sched_cpu_nr_running_avg(cpu);
+
+	return sum;
+}
+EXPORT_SYMBOL_GPL(sched_nr_running_avg);
+
+#ifdef CONFIG_SMP
+/*
+ * Per-task utilization is the fraction of wall time the task spent
+ * running, decayed like the runqueue averages.  It is only brought up to
+ * date at the tick for the running task and when the task migrates, which
+ * is the one place it is consumed.
+ */
+static void sched_task_util_update(struct task_struct *p, u64 now)
+{
+	struct sched_entity *se = &p->se;
+	u64 window = now - se->lt_stamp;
+	u64 exec;
+
+	if (!se->lt_stamp)
+		goto out;
+	if ((s64)window < (s64)TICK_NSEC / 2)
+		return;
+
+	exec = min(se->sum_exec_runtime - se->lt_exec, window);
+	se->lt_util = sched_load_track_decay(se->lt_util,
+			div64_u64(exec << SCHED_LOAD_TRACK_SHIFT, window),
+			div64_u64(window + TICK_NSEC / 2, TICK_NSEC));
+out:
+	se->lt_stamp = now;
+	se->lt_exec = se->sum_exec_runtime;
+}
+
+static ATOMIC_NOTIFIER_HEAD(sched_migration_notifier);
+
+int register_sched_migration_notifier(struct notifier_block *nb)
+{
+	return atomic_notifier_chain_register(&sched_migration_notifier, nb);
+}
+EXPORT_SYMBOL_GPL(register_sched_migration_notifier);
+
+int unregister_sched_migration_notifier(struct notifier_block *nb)
+{
+	return atomic_notifier_chain_unregister(&sched_migration_notifier, nb);
+}
+EXPORT_SYMBOL_GPL(unregister_sched_migration_notifier);
+
+/*
+ * Must be called without any runqueue lock held, listeners are expected
+ * to wake up threads of their own (e.g. a cpufreq governor).
+ */
+static void
+sched_migration_notify(int src_cpu, int dest_cpu, unsigned long load,
+		       bool wakeup)
+{
+	struct sched_migration_data data = {
+		.src_cpu	= src_cpu,
+		.dest_cpu	= dest_cpu,
+		.load		= load,
+		.wakeup		= wakeup,
+	};
+
+	if (!load)
+		return;
+
+	atomic_notifier_call_chain(&sched_migration_notifier, 0, &data);
+}
+
+/**
+ * sched_idle_set_state - record the idle state this cpu is entering
+ * @exit_latency: exit latency of the state in usecs, 0 on idle exit
+ *
+ * Lets wakeup placement prefer cpus that are cheap to wake up.
+ */
+void sched_idle_set_state(unsigned int exit_latency)
+{
+	this_rq()->idle_exit_latency = exit_latency;
+}
+
+/* Called with @rq->lock held, see pull_task(). */
+static inline unsigned long sched_take_pulled_load(struct rq *rq)
+{
+	unsigned long load = rq->lt_pulled;
+
+	rq->lt_pulled = 0;
+	return load;
+}
+#endif /* CONFIG_SMP */
+
 static void inc_nr_running(struct rq *rq)
 {
+	sched_load_track_account(rq);
 	rq->nr_running++;
 }
 
 static void dec_nr_running(struct rq *rq)
 {
+	sched_load_track_account(rq);
 	rq->nr_running--;
 }
 
@@ -1828,7 +2213,6 @@ static void activate_task(struct rq *rq, struct task_struct *p, int flags)
 		rq->nr_uninterruptible--;
 
 	enqueue_task(rq, p, flags);
-	inc_nr_running(rq);
 }
 
 /*
@@ -1840,7 +2224,6 @@ static void deactivate_task(struct rq *rq, struct task_struct *p, int flags)
 		rq->nr_uninterruptible++;
 
 	dequeue_task(rq, p, flags);
-	dec_nr_running(rq);
 }
 
 #ifdef CONFIG_IRQ_TIME_ACCOUNTING
@@ -2217,6 +2600,7 @@ void set_task_cpu(struct task_struct *p, unsigned int new_cpu)
 	trace_sched_migrate_task(p, new_cpu);
 
 	if (task_cpu(p) != new_cpu) {
+		sched_task_util_update(p, local_clock());
 		p->se.nr_migrations++;
 		perf_sw_event(PERF_COUNT_SW_CPU_MIGRATIONS, 1, 1, NULL, 0);
 	}
@@ -2673,6 +3057,10 @@ try_to_wake_up(struct task_struct *p, unsigned int state, int wake_flags)
 {
 	unsigned long flags;
 	int cpu, success = 0;
+#ifdef CONFIG_SMP
+	unsigned long load = 0;
+	int src_cpu = 0;
+#endif
 
 	smp_wmb();
 	raw_spin_lock_irqsave(&p->pi_lock, flags);
@@ -2719,7 +3107,9 @@ try_to_wake_up(struct task_struct *p, unsigned int state, int wake_flags)
 	cpu = select_task_rq(p, SD_BALANCE_WAKE, wake_flags);
 	if (task_cpu(p) != cpu) {
 		wake_flags |= WF_MIGRATED;
+		src_cpu = task_cpu(p);
 		set_task_cpu(p, cpu);
+		load = p->se.lt_util;
 	}
 #endif /* CONFIG_SMP */
 
@@ -2729,6 +3119,11 @@ stat:
 out:
 	raw_spin_unlock_irqrestore(&p->pi_lock, flags);
 
+#ifdef CONFIG_SMP
+	if (wake_flags & WF_MIGRATED)
+		sched_migration_notify(src_cpu, cpu, load, true);
+#endif
+
 	return success;
 }
 
@@ -2809,6 +3204,11 @@ static void __sched_fork(struct task_struct *p)
 	p->se.vruntime			= 0;
 	INIT_LIST_HEAD(&p->se.group_node);
 
+#ifdef CONFIG_SMP
+	p->se.lt_stamp			= 0;
+	p->se.lt_util			= 0;
+#endif
+
 #ifdef CONFIG_SCHEDSTATS
 	memset(&p->se.statistics, 0, sizeof(p->se.statistics));
 #endif
@@ -4073,7 +4473,12 @@ void scheduler_tick(void)
 	raw_spin_lock(&rq->lock);
 	update_rq_clock(rq);
 	update_cpu_load_active(rq);
+	sched_load_track_fold(rq);
 	curr->sched_class->task_tick(rq, curr, 0);
+#ifdef CONFIG_SMP
+	if (curr != rq->idle)
+		sched_task_util_update(curr, rq->clock);
+#endif
 	raw_spin_unlock(&rq->lock);
 
 	perf_event_task_tick();
@@ -4372,6 +4777,53 @@ int mutex_spin_on_owner(struct mutex *lock, struct task_struct *owner)
 }
 #endif
 
+#ifdef CONFIG_RWSEM_SPIN_ON_OWNER
+static inline bool rwsem_owner_running(struct rw_semaphore *sem,
+				       struct task_struct *owner)
+{
+	bool ret = false;
+
+	rcu_read_lock();
+	if (sem->owner != owner)
+		goto fail;
+
+	/* See owner_running() */
+	barrier();
+
+	ret = owner->on_cpu;
+fail:
+	rcu_read_unlock();
+
+	return ret;
+}
+
+/*
+ * Spin while the writer owning @sem runs.  Returns 1 if the lock was
+ * released and is worth trying, 0 if we should go to sleep instead.
+ */
+int rwsem_spin_on_owner(struct rw_semaphore *sem, struct task_struct *owner)
+{
+	if (!sched_feat(OWNER_SPIN))
+		return 0;
+
+	while (rwsem_owner_running(sem, owner)) {
+		if (need_resched())
+			return 0;
+
+		arch_mutex_cpu_relax();
+	}
+
+	/*
+	 * The owner went to sleep with the lock held, or another writer
+	 * took it over: either way the wait will be long.
+	 */
+	if (ACCESS_ONCE(sem->owner))
+		return 0;
+
+	return 1;
+}
+#endif
+
 #ifdef CONFIG_PREEMPT
 /*
  * this is the entry point to schedule() from in-kernel preemption
@@ -6210,6 +6662,9 @@ static void migrate_tasks(unsigned int dead_cpu)
 	 */
 	rq->stop = NULL;
 
+	/* Ensure any throttled groups are reachable by pick_next_task */
+	unthrottle_offline_cfs_rqs(rq);
+
 	for ( ; ; ) {
 		/*
 		 * There's this thread running, bail when that's the only
@@ -8001,6 +8456,7 @@ static void init_tg_cfs_entry(struct task_group *tg, struct cfs_rq *cfs_rq,
 	tg->cfs_rq[cpu] = cfs_rq;
 	init_cfs_rq(cfs_rq, rq);
 	cfs_rq->tg = tg;
+	init_cfs_rq_runtime(cfs_rq);
 
 	tg->se[cpu] = se;
 	/* se could be NULL for root_task_group */
@@ -8117,6 +8573,7 @@ void __init sched_init(void)
 #ifdef CONFIG_FAIR_GROUP_SCHED
 		root_task_group.shares = root_task_group_load;
 		INIT_LIST_HEAD(&rq->leaf_cfs_rq_list);
+		init_cfs_bandwidth(&root_task_group.cfs_bandwidth);
 		/*
 		 * How much cpu bandwidth does root_task_group get?
 		 *
@@ -8390,6 +8847,8 @@ static void free_fair_sched_group(struct task_group *tg)
 {
 	int i;
 
+	destroy_cfs_bandwidth(tg_cfs_bandwidth(tg));
+
 	for_each_possible_cpu(i) {
 		if (tg->cfs_rq)
 			kfree(tg->cfs_rq[i]);
@@ -8417,6 +8876,8 @@ int alloc_fair_sched_group(struct task_group *tg, struct task_group *parent)
 
 	tg->shares = NICE_0_LOAD;
 
+	init_cfs_bandwidth(tg_cfs_bandwidth(tg));
+
 	for_each_possible_cpu(i) {
 		cfs_rq = kzalloc_node(sizeof(struct cfs_rq),
 				      GFP_KERNEL, cpu_to_node(i));
@@ -8695,12 +9156,7 @@ unsigned long sched_group_shares(struct task_group *tg)
 }
 #endif
 
-#ifdef CONFIG_RT_GROUP_SCHED
-/*
- * Ensure that the real time constraints are schedulable.
- */
-static DEFINE_MUTEX(rt_constraints_mutex);
-
+#if defined(CONFIG_RT_GROUP_SCHED) || defined(CONFIG_CFS_BANDWIDTH)
 static unsigned long to_ratio(u64 period, u64 runtime)
 {
 	if (runtime == RUNTIME_INF)
@@ -8708,6 +9164,13 @@ static unsigned long to_ratio(u64 period, u64 runtime)
 
 	return div64_u64(runtime << 20, period);
 }
+#endif
+
+#ifdef CONFIG_RT_GROUP_SCHED
+/*
+ * Ensure that the real time constraints are schedulable.
+ */
+static DEFINE_MUTEX(rt_constraints_mutex);
 
 /* Must be called with tasklist_lock held */
 static inline int tg_has_rt_tasks(struct task_group *tg)
@@ -9072,6 +9535,237 @@ static u64 cpu_shares_read_u64(struct cgroup *cgrp, struct cftype *cft)
 
 	return (u64) scale_load_down(tg->shares);
 }
+
+#ifdef CONFIG_CFS_BANDWIDTH
+static DEFINE_MUTEX(cfs_constraints_mutex);
+
+static const u64 max_cfs_quota_period = 1 * NSEC_PER_SEC; /* 1s */
+static const u64 min_cfs_quota_period = 1 * NSEC_PER_MSEC; /* 1ms */
+
+static int __cfs_schedulable(struct task_group *tg, u64 period, u64 runtime);
+
+static int tg_set_cfs_bandwidth(struct task_group *tg, u64 period, u64 quota)
+{
+	int i, ret = 0, runtime_enabled;
+	struct cfs_bandwidth *cfs_b = tg_cfs_bandwidth(tg);
+
+	if (tg == &root_task_group)
+		return -EINVAL;
+
+	/*
+	 * Ensure we have at some amount of bandwidth every period.  This is
+	 * to prevent reaching a state of large arrears when throttled via
+	 * entity_tick() resulting in prolonged exit starvation.
+	 */
+	if (quota < min_cfs_quota_period || period < min_cfs_quota_period)
+		return -EINVAL;
+
+	/*
+	 * Likewise, bound things on the otherside by preventing insane quota
+	 * periods.  This also allows us to normalize in computing quota
+	 * feasibility.
+	 */
+	if (period > max_cfs_quota_period)
+		return -EINVAL;
+
+	mutex_lock(&cfs_constraints_mutex);
+	ret = __cfs_schedulable(tg, period, quota);
+	if (ret)
+		goto out_unlock;
+
+	runtime_enabled = quota != RUNTIME_INF;
+	raw_spin_lock_irq(&cfs_b->lock);
+	cfs_b->period = ns_to_ktime(period);
+	cfs_b->quota = quota;
+
+	__refill_cfs_bandwidth_runtime(cfs_b);
+	/* restart the period timer (if active) to handle new period expiry */
+	if (runtime_enabled && cfs_b->timer_active) {
+		/* force a reprogram */
+		cfs_b->timer_active = 0;
+		__start_cfs_bandwidth(cfs_b);
+	}
+	raw_spin_unlock_irq(&cfs_b->lock);
+
+	for_each_possible_cpu(i) {
+		struct cfs_rq *cfs_rq = tg->cfs_rq[i];
+		struct rq *rq = rq_of(cfs_rq);
+
+		raw_spin_lock_irq(&rq->lock);
+		cfs_rq->runtime_enabled = runtime_enabled;
+		cfs_rq->runtime_remaining = 0;
+
+		if (cfs_rq_throttled(cfs_rq))
+			unthrottle_cfs_rq(cfs_rq);
+		raw_spin_unlock_irq(&rq->lock);
+	}
+out_unlock:
+	mutex_unlock(&cfs_constraints_mutex);
+
+	return ret;
+}
+
+static int tg_set_cfs_quota(struct task_group *tg, long cfs_quota_us)
+{
+	u64 quota, period;
+
+	period = ktime_to_ns(tg_cfs_bandwidth(tg)->period);
+	if (cfs_quota_us < 0)
+		quota = RUNTIME_INF;
+	else
+		quota = (u64)cfs_quota_us * NSEC_PER_USEC;
+
+	return tg_set_cfs_bandwidth(tg, period, quota);
+}
+
+static long tg_get_cfs_quota(struct task_group *tg)
+{
+	u64 quota_us;
+
+	if (tg_cfs_bandwidth(tg)->quota == RUNTIME_INF)
+		return -1;
+
+	quota_us = tg_cfs_bandwidth(tg)->quota;
+	do_div(quota_us, NSEC_PER_USEC);
+
+	return quota_us;
+}
+
+static int tg_set_cfs_period(struct task_group *tg, long cfs_period_us)
+{
+	u64 quota, period;
+
+	if (cfs_period_us <= 0)
+		return -EINVAL;
+
+	period = (u64)cfs_period_us * NSEC_PER_USEC;
+	quota = tg_cfs_bandwidth(tg)->quota;
+
+	return tg_set_cfs_bandwidth(tg, period, quota);
+}
+
+static long tg_get_cfs_period(struct task_group *tg)
+{
+	u64 cfs_period_us;
+
+	cfs_period_us = ktime_to_ns(tg_cfs_bandwidth(tg)->period);
+	do_div(cfs_period_us, NSEC_PER_USEC);
+
+	return cfs_period_us;
+}
+
+static s64 cpu_cfs_quota_read_s64(struct cgroup *cgrp, struct cftype *cft)
+{
+	return tg_get_cfs_quota(cgroup_tg(cgrp));
+}
+
+static int cpu_cfs_quota_write_s64(struct cgroup *cgrp, struct cftype *cftype,
+				   s64 cfs_quota_us)
+{
+	return tg_set_cfs_quota(cgroup_tg(cgrp), cfs_quota_us);
+}
+
+static u64 cpu_cfs_period_read_u64(struct cgroup *cgrp, struct cftype *cft)
+{
+	return tg_get_cfs_period(cgroup_tg(cgrp));
+}
+
+static int cpu_cfs_period_write_u64(struct cgroup *cgrp, struct cftype *cftype,
+				    u64 cfs_period_us)
+{
+	return tg_set_cfs_period(cgroup_tg(cgrp), cfs_period_us);
+}
+
+struct cfs_schedulable_data {
+	struct task_group *tg;
+	u64 period, quota;
+};
+
+/*
+ * normalize group quota/period to be quota/max_period
+ * note: units are usecs
+ */
+static u64 normalize_cfs_quota(struct task_group *tg,
+			       struct cfs_schedulable_data *d)
+{
+	u64 quota, period;
+
+	if (tg == d->tg) {
+		period = d->period;
+		quota = d->quota;
+	} else {
+		period = tg_get_cfs_period(tg);
+		quota = tg_get_cfs_quota(tg);
+	}
+
+	/* note: these should typically be equivalent */
+	if (quota == RUNTIME_INF || quota == -1)
+		return RUNTIME_INF;
+
+	return to_ratio(period, quota);
+}
+
+/*
+ * A child may not be given more bandwidth than its parent; groups without a
+ * limit of their own inherit the one above them.
+ */
+static int tg_cfs_schedulable_down(struct task_group *tg, void *data)
+{
+	struct cfs_schedulable_data *d = data;
+	struct cfs_bandwidth *cfs_b = tg_cfs_bandwidth(tg);
+	s64 quota = 0, parent_quota = -1;
+
+	if (!tg->parent) {
+		quota = RUNTIME_INF;
+	} else {
+		struct cfs_bandwidth *parent_b = tg_cfs_bandwidth(tg->parent);
+
+		quota = normalize_cfs_quota(tg, d);
+		parent_quota = parent_b->hierarchal_quota;
+
+		/*
+		 * ensure max(child_quota) <= parent_quota, inherit when no
+		 * limit is set
+		 */
+		if (quota == RUNTIME_INF)
+			quota = parent_quota;
+		else if (parent_quota != RUNTIME_INF && quota > parent_quota)
+			return -EINVAL;
+	}
+	cfs_b->hierarchal_quota = quota;
+
+	return 0;
+}
+
+static int __cfs_schedulable(struct task_group *tg, u64 period, u64 quota)
+{
+	struct cfs_schedulable_data data = {
+		.tg = tg,
+		.period = period,
+		.quota = quota,
+	};
+
+	if (quota != RUNTIME_INF) {
+		do_div(data.period, NSEC_PER_USEC);
+		do_div(data.quota, NSEC_PER_USEC);
+	}
+
+	return walk_tg_tree(tg_cfs_schedulable_down, tg_nop, &data);
+}
+
+static int cpu_stats_show(struct cgroup *cgrp, struct cftype *cft,
+			  struct cgroup_map_cb *cb)
+{
+	struct task_group *tg = cgroup_tg(cgrp);
+	struct cfs_bandwidth *cfs_b = tg_cfs_bandwidth(tg);
+
+	cb->fill(cb, "nr_periods", cfs_b->nr_periods);
+	cb->fill(cb, "nr_throttled", cfs_b->nr_throttled);
+	cb->fill(cb, "throttled_time", cfs_b->throttled_time);
+
+	return 0;
+}
+#endif /* CONFIG_CFS_BANDWIDTH */
 #endif /* CONFIG_FAIR_GROUP_SCHED */
 
 #ifdef CONFIG_RT_GROUP_SCHED
@@ -9106,6 +9800,22 @@ static struct cftype cpu_files[] = {
 		.write_u64 = cpu_shares_write_u64,
 	},
 #endif
+#ifdef CONFIG_CFS_BANDWIDTH
+	{
+		.name = "cfs_quota_us",
+		.read_s64 = cpu_cfs_quota_read_s64,
+		.write_s64 = cpu_cfs_quota_write_s64,
+	},
+	{
+		.name = "cfs_period_us",
+		.read_u64 = cpu_cfs_period_read_u64,
+		.write_u64 = cpu_cfs_period_write_u64,
+	},
+	{
+		.name = "stat",
+		.read_map = cpu_stats_show,
+	},
+#endif
 #ifdef CONFIG_RT_GROUP_SCHED
 	{
 		.name = "rt_runtime_us",
@@ -453,6 +453,9 @@ void proc_sched_show_task(struct task_struct *p, struct seq_file *m)
 	P(se.statistics.nr_wakeups_affine_attempts);
 	P(se.statistics.nr_wakeups_passive);
 	P(se.statistics.nr_wakeups_idle);
+	PN(se.statistics.wakeup_latency_max);
+	PN(se.statistics.wakeup_latency_sum);
+	P(se.statistics.wakeup_latency_count);
 
 	{
 		u64 avg_atom, avg_per_cpu;
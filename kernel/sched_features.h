@@ -24,6 +24,14 @@ SCHED_FEAT(WAKEUP_PREEMPT, 1)
  */
 SCHED_FEAT(AFFINE_WAKEUPS, 1)
 
+/*
+ * On wakeup, pack the task onto an already running cpu that has spare
+ * capacity rather than waking an idle one, and when a cpu has to be
+ * woken pick the one in the shallowest idle state. See
+ * select_packing_cpu().
+ */
+SCHED_FEAT(PACKING_WAKEUPS, 0)
+
 /*
  * Prefer to schedule the task we woke last (assuming it failed
  * wakeup-preemption), since its likely going to consume data we
@@ -104,6 +104,89 @@ static int __init proc_schedstat_init(void)
 }
 module_init(proc_schedstat_init);
 
+static const char * const sched_hist_names[SCHED_HIST_NR] = {
+	[SCHED_HIST_WAKEUP]	= "wakeup",
+	[SCHED_HIST_PREEMPT]	= "preempt",
+	[SCHED_HIST_SLICE]	= "slice",
+};
+
+static int show_schedstat_hist(struct seq_file *seq, void *v)
+{
+	int cpu, i, j;
+
+	seq_printf(seq, "version 1\n");
+	seq_printf(seq, "bucket_ns");
+	for (j = 0; j < SCHED_HIST_BUCKETS - 1; j++)
+		seq_printf(seq, " %llu", 1ULL << (SCHED_HIST_SHIFT + j));
+	seq_printf(seq, " inf\n");
+
+	for_each_online_cpu(cpu) {
+		struct rq *rq = cpu_rq(cpu);
+
+		for (i = 0; i < SCHED_HIST_NR; i++) {
+			seq_printf(seq, "cpu%d %s", cpu, sched_hist_names[i]);
+			for (j = 0; j < SCHED_HIST_BUCKETS; j++)
+				seq_printf(seq, " %u",
+					   ACCESS_ONCE(rq->sched_hist[i][j]));
+			seq_printf(seq, "\n");
+		}
+	}
+	return 0;
+}
+
+static int schedstat_hist_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, show_schedstat_hist, NULL);
+}
+
+static const struct file_operations proc_schedstat_hist_operations = {
+	.open    = schedstat_hist_open,
+	.read    = seq_read,
+	.llseek  = seq_lseek,
+	.release = single_release,
+};
+
+static int __init proc_schedstat_hist_init(void)
+{
+	proc_create("schedstat_hist", 0, NULL,
+		    &proc_schedstat_hist_operations);
+	return 0;
+}
+module_init(proc_schedstat_hist_init);
+
+/*
+ * Called with the runqueue lock held, so plain increments suffice and
+ * readers merely see a slightly stale histogram.
+ */
+static inline void
+sched_hist_add(struct rq *rq, int hist, unsigned long long delta)
+{
+	int bucket = fls64(delta >> SCHED_HIST_SHIFT);
+
+	if (bucket >= SCHED_HIST_BUCKETS)
+		bucket = SCHED_HIST_BUCKETS - 1;
+	rq->sched_hist[hist][bucket]++;
+}
+
+static inline void
+sched_info_latency(struct task_struct *t, unsigned long long delta)
+{
+	struct sched_statistics *stats = &t->se.statistics;
+
+	if (t->sched_info.queued_preempt) {
+		sched_hist_add(task_rq(t), SCHED_HIST_PREEMPT, delta);
+		trace_sched_stat_preempt_latency(t, delta);
+		return;
+	}
+
+	sched_hist_add(task_rq(t), SCHED_HIST_WAKEUP, delta);
+	trace_sched_stat_wakeup_latency(t, delta);
+
+	stats->wakeup_latency_max = max(stats->wakeup_latency_max, delta);
+	stats->wakeup_latency_sum += delta;
+	stats->wakeup_latency_count++;
+}
+
 /*
  * Expects runqueue lock to be held for atomicity of update
  */
@@ -122,8 +205,10 @@ rq_sched_info_arrive(struct rq *rq, unsigned long long delta)
 static inline void
 rq_sched_info_depart(struct rq *rq, unsigned long long delta)
 {
-	if (rq)
+	if (rq) {
 		rq->rq_cpu_time += delta;
+		sched_hist_add(rq, SCHED_HIST_SLICE, delta);
+	}
 }
 
 static inline void
@@ -145,6 +230,9 @@ rq_sched_info_dequeued(struct rq *rq, unsigned long long delta)
 static inline void
 rq_sched_info_depart(struct rq *rq, unsigned long long delta)
 {}
+static inline void
+sched_info_latency(struct task_struct *t, unsigned long long delta)
+{}
 # define schedstat_inc(rq, field)	do { } while (0)
 # define schedstat_add(rq, field, amt)	do { } while (0)
 # define schedstat_set(var, val)	do { } while (0)
@@ -184,9 +272,12 @@ static void sched_info_arrive(struct task_struct *t)
 {
 	unsigned long long now = task_rq(t)->clock, delta = 0;
 
-	if (t->sched_info.last_queued)
+	if (t->sched_info.last_queued) {
 		delta = now - t->sched_info.last_queued;
+		sched_info_latency(t, delta);
+	}
 	sched_info_reset_dequeued(t);
+	t->sched_info.queued_preempt = 0;
 	t->sched_info.run_delay += delta;
 	t->sched_info.last_arrival = now;
 	t->sched_info.pcount++;
@@ -220,8 +311,10 @@ static inline void sched_info_depart(struct task_struct *t)
 
 	rq_sched_info_depart(task_rq(t), delta);
 
-	if (t->state == TASK_RUNNING)
+	if (t->state == TASK_RUNNING) {
 		sched_info_queued(t);
+		t->sched_info.queued_preempt = 1;
+	}
 }
 
 /*
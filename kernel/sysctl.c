@@ -57,6 +57,7 @@
 #include <linux/pipe_fs_i.h>
 #include <linux/oom.h>
 #include <linux/kmod.h>
+#include <linux/prezero.h>
 
 #include <asm/uaccess.h>
 #include <asm/processor.h>
@@ -270,6 +271,7 @@ static int max_sched_tunable_scaling = SCHED_TUNABLESCALING_END-1;
 #ifdef CONFIG_COMPACTION
 static int min_extfrag_threshold;
 static int max_extfrag_threshold = 1000;
+static int max_compact_proactive_secs = 24 * 60 * 60;
 #endif
 
 static struct ctl_table kern_table[] = {
@@ -345,6 +347,15 @@ static struct ctl_table kern_table[] = {
 		.mode		= 0644,
 		.proc_handler	= proc_dointvec,
 	},
+	{
+		.procname	= "sched_packing_util",
+		.data		= &sysctl_sched_packing_util,
+		.maxlen		= sizeof(unsigned int),
+		.mode		= 0644,
+		.proc_handler	= proc_dointvec_minmax,
+		.extra1		= &zero,
+		.extra2		= &one_hundred,
+	},
 	{
 		.procname	= "timer_migration",
 		.data		= &sysctl_timer_migration,
@@ -369,6 +380,16 @@ static struct ctl_table kern_table[] = {
 		.mode		= 0644,
 		.proc_handler	= sched_rt_handler,
 	},
+#ifdef CONFIG_CFS_BANDWIDTH
+	{
+		.procname	= "sched_cfs_bandwidth_slice_us",
+		.data		= &sysctl_sched_cfs_bandwidth_slice,
+		.maxlen		= sizeof(unsigned int),
+		.mode		= 0644,
+		.proc_handler	= proc_dointvec_minmax,
+		.extra1		= &one,
+	},
+#endif
 #ifdef CONFIG_SCHED_AUTOGROUP
 	{
 		.procname	= "sched_autogroup_enabled",
@@ -398,6 +419,15 @@ static struct ctl_table kern_table[] = {
 		.proc_handler	= proc_dointvec,
 	},
 #endif
+	{
+		.procname	= "timer_coalesce_pct",
+		.data		= &sysctl_timer_coalesce_pct,
+		.maxlen		= sizeof(unsigned int),
+		.mode		= 0644,
+		.proc_handler	= proc_dointvec_minmax,
+		.extra1		= &zero,
+		.extra2		= &one_hundred,
+	},
 	{
 		.procname	= "panic",
 		.data		= &panic_timeout,
@@ -1192,6 +1222,15 @@ static struct ctl_table vm_table[] = {
 		.extra1		= &min_extfrag_threshold,
 		.extra2		= &max_extfrag_threshold,
 	},
+	{
+		.procname	= "compact_proactive_secs",
+		.data		= &sysctl_compact_proactive_secs,
+		.maxlen		= sizeof(int),
+		.mode		= 0644,
+		.proc_handler	= proc_dointvec_minmax,
+		.extra1		= &zero,
+		.extra2		= &max_compact_proactive_secs,
+	},
 
 #endif /* CONFIG_COMPACTION */
 	{
@@ -1235,6 +1274,27 @@ static struct ctl_table vm_table[] = {
 		.proc_handler	= proc_dointvec_minmax,
 		.extra1		= &zero,
 	},
+#endif
+#ifdef CONFIG_ANON_LARGE_PAGES
+	{
+		.procname	= "anon_large_pages",
+		.data		= &sysctl_anon_large_pages,
+		.maxlen		= sizeof(sysctl_anon_large_pages),
+		.mode		= 0644,
+		.proc_handler	= proc_dointvec_minmax,
+		.extra1		= &zero,
+		.extra2		= &two,
+	},
+#endif
+#ifdef CONFIG_PREZERO_PAGES
+	{
+		.procname	= "prezero_pages",
+		.data		= &sysctl_prezero_pages,
+		.maxlen		= sizeof(sysctl_prezero_pages),
+		.mode		= 0644,
+		.proc_handler	= prezero_sysctl_handler,
+		.extra1		= &zero,
+	},
 #endif
 	{
 		.procname	= "laptop_mode",
@@ -129,6 +129,25 @@ static int __init setup_tick_nohz(char *str)
 
 __setup("nohz=", setup_tick_nohz);
 
+/*
+ * Keep the tick running when the idle period is predicted to be shorter
+ * than a tick?
+ */
+static int tick_nohz_predict_enabled __read_mostly = 1;
+
+static int __init setup_tick_nohz_predict(char *str)
+{
+	if (!strcmp(str, "off"))
+		tick_nohz_predict_enabled = 0;
+	else if (!strcmp(str, "on"))
+		tick_nohz_predict_enabled = 1;
+	else
+		return 0;
+	return 1;
+}
+
+__setup("nohz_predict=", setup_tick_nohz_predict);
+
 /**
  * tick_nohz_update_jiffies - update jiffies when idle was interrupted
  *
@@ -176,10 +195,91 @@ update_ts_time_stats(int cpu, struct tick_sched *ts, ktime_t now, u64 *last_upda
 
 }
 
+/*
+ * Idle length prediction.
+ *
+ * Every idle period ends with an interrupt, so the lengths of the last
+ * TICK_IDLE_INTERVALS periods describe when this cpu's interrupts tend to
+ * arrive.  If they agree closely (standard deviation at most a quarter of
+ * the mean, leaving out the longest one, which usually ran into a timer),
+ * the mean is taken as the length of the next idle period.
+ */
+#define TICK_IDLE_MAX_US	USEC_PER_SEC
+
+static s64 tick_nohz_predict_idle(struct tick_sched *ts)
+{
+	u64 sum = 0, avg, variance = 0;
+	int i, n = 0, max_i = 0;
+
+	for (i = 1; i < TICK_IDLE_INTERVALS; i++) {
+		if (ts->idle_intervals[i] > ts->idle_intervals[max_i])
+			max_i = i;
+	}
+
+	for (i = 0; i < TICK_IDLE_INTERVALS; i++) {
+		if (i == max_i || !ts->idle_intervals[i])
+			continue;
+		sum += ts->idle_intervals[i];
+		n++;
+	}
+	if (n < TICK_IDLE_INTERVALS / 2)
+		return 0;
+	avg = div_u64(sum, n);
+
+	for (i = 0; i < TICK_IDLE_INTERVALS; i++) {
+		s64 diff = (s64)ts->idle_intervals[i] - avg;
+
+		if (i == max_i || !ts->idle_intervals[i])
+			continue;
+		variance += diff * diff;
+	}
+	variance = div_u64(variance, n);
+
+	if (variance * 16 > avg * avg)
+		return 0;
+
+	return avg * NSEC_PER_USEC;
+}
+
+static void tick_nohz_idle_account(struct tick_sched *ts, ktime_t now)
+{
+	s64 delta = ktime_to_ns(ktime_sub(now, ts->idle_pred_entry));
+	s64 us = ktime_to_us(ktime_sub(now, ts->idle_pred_entry));
+
+	if (ts->idle_predicted) {
+		if (delta < ts->idle_predicted / 2 ||
+		    delta > ts->idle_predicted * 2)
+			ts->idle_pred_misses++;
+		else
+			ts->idle_pred_hits++;
+	}
+
+	if (ts->idle_tick_kept && delta >= ktime_to_ns(ts->sleep_length)) {
+		/*
+		 * Only the tick we kept ended this period, so its real length
+		 * is unknown.  Record it as long; otherwise every later
+		 * prediction would be short and the tick would never stop.
+		 */
+		ts->idle_keep_misses++;
+		us = TICK_IDLE_MAX_US;
+	} else if (ts->tick_stopped && delta < tick_period.tv64) {
+		ts->idle_short_stops++;
+	}
+
+	ts->idle_intervals[ts->idle_interval_ptr] =
+		min_t(s64, max_t(s64, us, 1), TICK_IDLE_MAX_US);
+	if (++ts->idle_interval_ptr >= TICK_IDLE_INTERVALS)
+		ts->idle_interval_ptr = 0;
+	ts->idle_predicted = 0;
+	ts->idle_tick_kept = 0;
+}
+
 static void tick_nohz_stop_idle(int cpu, ktime_t now)
 {
 	struct tick_sched *ts = &per_cpu(tick_cpu_sched, cpu);
 
+	if (ts->idle_active)
+		tick_nohz_idle_account(ts, now);
 	update_ts_time_stats(cpu, ts, now, NULL);
 	ts->idle_active = 0;
 
@@ -194,6 +294,8 @@ static ktime_t tick_nohz_start_idle(int cpu, struct tick_sched *ts)
 
 	update_ts_time_stats(cpu, ts, now, NULL);
 
+	if (!ts->idle_active)
+		ts->idle_pred_entry = now;
 	ts->idle_entrytime = now;
 	ts->idle_active = 1;
 	sched_clock_idle_sleep_event();
@@ -345,6 +447,18 @@ void tick_nohz_stop_sched_tick(int inidle)
 	if (!ts->tick_stopped && delta_jiffies == 1)
 		goto out;
 
+	/*
+	 * Nor if an interrupt is expected within the next tick anyway:
+	 * stopping and restarting it would cost more than it saves.
+	 */
+	ts->idle_predicted = tick_nohz_predict_idle(ts);
+	if (!ts->tick_stopped && tick_nohz_predict_enabled &&
+	    ts->idle_predicted && ts->idle_predicted < tick_period.tv64) {
+		ts->idle_tick_kept = 1;
+		ts->idle_tick_keeps++;
+		goto out;
+	}
+
 	/* Schedule the tick, if we are at least one jiffie off */
 	if ((long)delta_jiffies >= 1) {
 
@@ -470,6 +584,19 @@ ktime_t tick_nohz_get_sleep_length(void)
 	return ts->sleep_length;
 }
 
+/**
+ * tick_nohz_get_predicted_length - return the predicted length of this idle
+ *
+ * Based on the lengths of recent idle periods; 0 when they show no pattern.
+ * Called from power state control code with interrupts disabled
+ */
+ktime_t tick_nohz_get_predicted_length(void)
+{
+	struct tick_sched *ts = &__get_cpu_var(tick_cpu_sched);
+
+	return ns_to_ktime(ts->idle_predicted);
+}
+
 static void tick_nohz_restart(struct tick_sched *ts, ktime_t now)
 {
 	hrtimer_cancel(&ts->sched_timer);
@@ -718,7 +845,6 @@ void tick_check_idle(int cpu)
 static void update_rq_stats(void)
 {
 	unsigned long jiffy_gap = 0;
-	unsigned int rq_avg = 0;
 	unsigned long flags = 0;
 
 	jiffy_gap = jiffies - rq_info.rq_poll_last_jiffy;
@@ -727,21 +853,9 @@ static void update_rq_stats(void)
 
 		spin_lock_irqsave(&rq_lock, flags);
 
-		if (!rq_info.rq_avg)
-			rq_info.rq_poll_total_jiffies = 0;
-
-		rq_avg = nr_running() * 10;
-
-		if (rq_info.rq_poll_total_jiffies) {
-			rq_avg = (rq_avg * jiffy_gap) +
-				(rq_info.rq_avg *
-				 rq_info.rq_poll_total_jiffies);
-			do_div(rq_avg,
-			       rq_info.rq_poll_total_jiffies + jiffy_gap);
-		}
-
-		rq_info.rq_avg =  rq_avg;
-		rq_info.rq_poll_total_jiffies += jiffy_gap;
+		/* the scheduler already keeps a decayed average for us */
+		rq_info.rq_avg = (sched_nr_running_avg() * 10) >>
+				 SCHED_LOAD_TRACK_SHIFT;
 		rq_info.rq_poll_last_jiffy = jiffies;
 
 		spin_unlock_irqrestore(&rq_lock, flags);
@@ -40,6 +40,8 @@
 #include <linux/irq_work.h>
 #include <linux/sched.h>
 #include <linux/slab.h>
+#include <linux/debugfs.h>
+#include <linux/seq_file.h>
 
 #include <asm/uaccess.h>
 #include <asm/unistd.h>
@@ -89,6 +91,26 @@ struct tvec_base boot_tvec_bases;
 EXPORT_SYMBOL(boot_tvec_bases);
 static DEFINE_PER_CPU(struct tvec_base *, tvec_bases) = &boot_tvec_bases;
 
+/*
+ * Coalescing slack, in percent of the timeout, given to deferrable timers
+ * and to timeouts slept by user tasks when they have no explicit slack.
+ * Such a timer is queued on the first jiffy of its window that already
+ * has timers pending, so it expires in the same softirq as they do.
+ * Deferrable timers already put up with arbitrary delays on an idle cpu,
+ * and 5% keeps a user timeout within a jiffy of what was asked for up to
+ * 20 jiffies.  0 disables coalescing.
+ */
+unsigned int sysctl_timer_coalesce_pct __read_mostly = 5;
+
+struct timer_coalesce_stats {
+	unsigned long expired;		/* timer callbacks run */
+	unsigned long deferrable;	/* ... of which deferrable */
+	unsigned long batches;		/* jiffies that ran at least one timer */
+	unsigned long idle_batches;	/* ... of which interrupted idle */
+	unsigned long slacked;		/* expiries moved by slack */
+};
+static DEFINE_PER_CPU(struct timer_coalesce_stats, timer_coalesce_stats);
+
 /* Functions below help us manage 'deferrable' flag */
 static inline unsigned int tbase_get_deferrable(struct tvec_base *base)
 {
@@ -655,9 +677,55 @@ static struct tvec_base *lock_timer_base(struct timer_list *timer,
 	}
 }
 
+/*
+ * Round @expires up towards @limit: calculate the highest bit where they
+ * differ, use it to make a mask and round @limit down with that mask, so
+ * that all the lower bits are zeros.
+ */
+static unsigned long slack_round(unsigned long expires, unsigned long limit)
+{
+	unsigned long mask = expires ^ limit;
+	int bit;
+
+	if (mask == 0)
+		return expires;
+
+	bit = find_last_bit(&mask, BITS_PER_LONG);
+
+	mask = (1 << bit) - 1;
+
+	return limit & ~(mask);
+}
+
+/*
+ * Pick the expiry of a timer that may fire anywhere in [@expires, @limit]:
+ * the first jiffy of the window that already has timers queued on @base,
+ * so that it runs in the same softirq as they do, or else the window
+ * rounded as slack_round() does.  Only tv1 holds timers by exact jiffy,
+ * so windows past it are just rounded.  Called with base->lock held.
+ */
+static unsigned long
+coalesce_expiry(struct tvec_base *base, unsigned long expires,
+		unsigned long limit)
+{
+	unsigned long j;
+
+	for (j = expires; !time_after(j, limit); j++) {
+		if (j - base->timer_jiffies >= TVR_SIZE)
+			break;
+		if (!list_empty(base->tv1.vec + (j & TVR_MASK)))
+			goto out;
+	}
+	j = slack_round(expires, limit);
+out:
+	if (j != expires)
+		this_cpu_inc(timer_coalesce_stats.slacked);
+	return j;
+}
+
 static inline int
 __mod_timer(struct timer_list *timer, unsigned long expires,
-						bool pending_only, int pinned)
+	    unsigned long expires_max, bool pending_only, int pinned)
 {
 	struct tvec_base *base, *new_base;
 	unsigned long flags;
@@ -707,6 +775,8 @@ __mod_timer(struct timer_list *timer, unsigned long expires,
 		}
 	}
 
+	if (expires_max != expires)
+		expires = coalesce_expiry(base, expires, expires_max);
 	timer->expires = expires;
 	if (time_before(timer->expires, base->next_timer) &&
 	    !tbase_get_deferrable(timer->base))
@@ -731,25 +801,17 @@ out_unlock:
  */
 int mod_timer_pending(struct timer_list *timer, unsigned long expires)
 {
-	return __mod_timer(timer, expires, true, TIMER_NOT_PINNED);
+	return __mod_timer(timer, expires, expires, true, TIMER_NOT_PINNED);
 }
 EXPORT_SYMBOL(mod_timer_pending);
 
 /*
  * Decide where to put the timer while taking the slack into account
- *
- * Algorithm:
- *   1) calculate the maximum (absolute) time
- *   2) calculate the highest bit where the expires and new max are different
- *   3) use this bit to make a mask
- *   4) use the bitmask to round down the maximum time, so that all last
- *      bits are zeros
  */
 static inline
 unsigned long apply_slack(struct timer_list *timer, unsigned long expires)
 {
-	unsigned long expires_limit, mask;
-	int bit;
+	unsigned long expires_limit;
 
 	if (timer->slack >= 0) {
 		expires_limit = expires + timer->slack;
@@ -761,17 +823,47 @@ unsigned long apply_slack(struct timer_list *timer, unsigned long expires)
 
 		expires_limit = expires + delta / 256;
 	}
-	mask = expires ^ expires_limit;
-	if (mask == 0)
-		return expires;
+	expires_limit = slack_round(expires, expires_limit);
 
-	bit = find_last_bit(&mask, BITS_PER_LONG);
+	if (expires_limit != expires)
+		this_cpu_inc(timer_coalesce_stats.slacked);
 
-	mask = (1 << bit) - 1;
+	return expires_limit;
+}
 
-	expires_limit = expires_limit & ~(mask);
+static unsigned long coalesce_slack(long delta)
+{
+	if (delta <= 0)
+		return 0;
 
-	return expires_limit;
+	return div_u64((u64)delta * sysctl_timer_coalesce_pct, 100);
+}
+
+/*
+ * End of the window a deferrable timer without an explicit slack may be
+ * coalesced into, or @expires if it does not coalesce.
+ */
+static unsigned long
+coalesce_limit(struct timer_list *timer, unsigned long expires)
+{
+	if (timer->slack >= 0 || !sysctl_timer_coalesce_pct ||
+	    !tbase_get_deferrable(timer->base))
+		return expires;
+
+	return expires + coalesce_slack(expires - jiffies);
+}
+
+/*
+ * Slack for a timeout slept by a user task: the task's own timer_slack_ns,
+ * as set with PR_SET_TIMERSLACK, or the coalescing share of the timeout,
+ * whichever is larger.
+ */
+static int user_timeout_slack(long timeout)
+{
+	unsigned long slack = nsecs_to_jiffies(current->timer_slack_ns);
+
+	slack = max(slack, coalesce_slack(timeout));
+	return min_t(unsigned long, slack, INT_MAX);
 }
 
 /**
@@ -796,17 +888,23 @@ unsigned long apply_slack(struct timer_list *timer, unsigned long expires)
  */
 int mod_timer(struct timer_list *timer, unsigned long expires)
 {
-	expires = apply_slack(timer, expires);
+	unsigned long expires_max = coalesce_limit(timer, expires);
+
+	if (expires_max == expires)
+		expires = expires_max = apply_slack(timer, expires);
 
 	/*
 	 * This is a common optimization triggered by the
 	 * networking code - if the timer is re-modified
 	 * to be the same thing then just return:
 	 */
-	if (timer_pending(timer) && timer->expires == expires)
+	if (timer_pending(timer) &&
+	    !time_before(timer->expires, expires) &&
+	    !time_after(timer->expires, expires_max))
 		return 1;
 
-	return __mod_timer(timer, expires, false, TIMER_NOT_PINNED);
+	return __mod_timer(timer, expires, expires_max, false,
+			   TIMER_NOT_PINNED);
 }
 EXPORT_SYMBOL(mod_timer);
 
@@ -828,7 +926,7 @@ int mod_timer_pinned(struct timer_list *timer, unsigned long expires)
 	if (timer->expires == expires && timer_pending(timer))
 		return 1;
 
-	return __mod_timer(timer, expires, false, TIMER_PINNED);
+	return __mod_timer(timer, expires, expires, false, TIMER_PINNED);
 }
 EXPORT_SYMBOL(mod_timer_pinned);
 
@@ -1111,6 +1209,11 @@ static inline void __run_timers(struct tvec_base *base)
 			cascade(base, &base->tv5, INDEX(3));
 		++base->timer_jiffies;
 		list_replace_init(base->tv1.vec + index, &work_list);
+		if (!list_empty(head)) {
+			__this_cpu_inc(timer_coalesce_stats.batches);
+			if (idle_cpu(smp_processor_id()))
+				__this_cpu_inc(timer_coalesce_stats.idle_batches);
+		}
 		while (!list_empty(head)) {
 			void (*fn)(unsigned long);
 			unsigned long data;
@@ -1120,6 +1223,9 @@ static inline void __run_timers(struct tvec_base *base)
 			data = timer->data;
 
 			timer_stats_account_timer(timer);
+			__this_cpu_inc(timer_coalesce_stats.expired);
+			if (tbase_get_deferrable(timer->base))
+				__this_cpu_inc(timer_coalesce_stats.deferrable);
 
 			base->running_timer = timer;
 			detach_timer(timer, 1);
@@ -1436,7 +1542,7 @@ static void process_timeout(unsigned long __data)
 signed long __sched schedule_timeout(signed long timeout)
 {
 	struct timer_list timer;
-	unsigned long expire;
+	unsigned long expire, expire_max;
 
 	switch (timeout)
 	{
@@ -1470,7 +1576,10 @@ signed long __sched schedule_timeout(signed long timeout)
 	expire = timeout + jiffies;
 
 	setup_timer_on_stack(&timer, process_timeout, (unsigned long)current);
-	__mod_timer(&timer, expire, false, TIMER_NOT_PINNED);
+	expire_max = expire;
+	if (sysctl_timer_coalesce_pct && !(current->flags & PF_KTHREAD))
+		expire_max += user_timeout_slack(timeout);
+	__mod_timer(&timer, expire, expire_max, false, TIMER_NOT_PINNED);
 	schedule();
 	del_singleshot_timer_sync(&timer);
 
@@ -1742,6 +1851,46 @@ void __init init_timers(void)
 	open_softirq(TIMER_SOFTIRQ, run_timer_softirq);
 }
 
+#ifdef CONFIG_DEBUG_FS
+static int timer_coalesce_show(struct seq_file *m, void *unused)
+{
+	int cpu;
+
+	seq_printf(m, "coalesce_pct: %u\n", sysctl_timer_coalesce_pct);
+	seq_printf(m, "%-4s %12s %12s %12s %12s %12s\n", "cpu", "expired",
+		   "deferrable", "batches", "idle_batches", "slacked");
+	for_each_possible_cpu(cpu) {
+		struct timer_coalesce_stats *st;
+
+		st = &per_cpu(timer_coalesce_stats, cpu);
+		seq_printf(m, "%-4d %12lu %12lu %12lu %12lu %12lu\n", cpu,
+			   st->expired, st->deferrable, st->batches,
+			   st->idle_batches, st->slacked);
+	}
+	return 0;
+}
+
+static int timer_coalesce_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, timer_coalesce_show, NULL);
+}
+
+static const struct file_operations timer_coalesce_fops = {
+	.open		= timer_coalesce_open,
+	.read		= seq_read,
+	.llseek		= seq_lseek,
+	.release	= single_release,
+};
+
+static int __init timer_coalesce_debugfs_init(void)
+{
+	debugfs_create_file("timer_coalesce", S_IRUGO, NULL, NULL,
+			    &timer_coalesce_fops);
+	return 0;
+}
+late_initcall(timer_coalesce_debugfs_init);
+#endif
+
 /**
  * msleep - sleep safely even with waitqueue interruptions
  * @msecs: Time in milliseconds to sleep for
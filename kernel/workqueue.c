@@ -41,6 +41,9 @@
 #include <linux/debug_locks.h>
 #include <linux/lockdep.h>
 #include <linux/idr.h>
+#include <linux/debugfs.h>
+#include <linux/seq_file.h>
+#include <linux/hash.h>
 
 #include "workqueue_sched.h"
 
@@ -191,6 +194,23 @@ struct global_cwq {
 	struct worker		*first_idle;	/* L: first idle worker */
 } ____cacheline_aligned_in_smp;
 
+#ifdef CONFIG_WQ_STATS
+/*
+ * Latency accounting, all times in nsecs.  Latency is from queueing to
+ * the start of execution and includes time spent on the delayed list
+ * because of max_active.  cpu_total is the on-cpu time of the worker
+ * while it was running the work function.
+ */
+struct wq_stats {
+	u64			nr_works;
+	u64			lat_total;
+	u64			lat_max;
+	u64			exec_total;
+	u64			exec_max;
+	u64			cpu_total;
+};
+#endif
+
 /*
  * The per-CPU workqueue.  The lower WORK_STRUCT_FLAG_BITS of
  * work_struct->data are used for flags and thus cwqs need to be
@@ -206,6 +226,9 @@ struct cpu_workqueue_struct {
 	int			nr_active;	/* L: nr of active works */
 	int			max_active;	/* L: max active works */
 	struct list_head	delayed_works;	/* L: delayed works */
+#ifdef CONFIG_WQ_STATS
+	struct wq_stats		stats;		/* L: latency statistics */
+#endif
 };
 
 /*
@@ -267,6 +290,9 @@ struct workqueue_struct {
 #ifdef CONFIG_LOCKDEP
 	struct lockdep_map	lockdep_map;
 #endif
+#ifdef CONFIG_WQ_STATS
+	bool			auto_cpu_intensive; /* treat as WQ_CPU_INTENSIVE */
+#endif
 };
 
 struct workqueue_struct *system_wq __read_mostly;
@@ -957,6 +983,9 @@ static void insert_work(struct cpu_workqueue_struct *cwq,
 	 */
 	smp_wmb();
 
+#ifdef CONFIG_WQ_STATS
+	work->queued_at = local_clock();
+#endif
 	list_add_tail(&work->entry, head);
 
 	/*
@@ -1808,6 +1837,128 @@ static void cwq_dec_nr_in_flight(struct cpu_workqueue_struct *cwq, int color,
 		complete(&cwq->wq->first_flusher->done);
 }
 
+#ifdef CONFIG_WQ_STATS
+/*
+ * Per work function statistics.  Work functions are hashed into a small
+ * open addressed table which is never shrunk; once it is full, works of
+ * functions not already in it are only counted in wq_func_stats_dropped.
+ */
+#define WQ_FUNC_STATS_BITS	7
+#define WQ_FUNC_STATS_SIZE	(1 << WQ_FUNC_STATS_BITS)
+
+struct wq_func_stats {
+	work_func_t		func;
+	const char		*wq_name;	/* last workqueue it ran on */
+	struct wq_stats		stats;
+};
+
+static struct wq_func_stats wq_func_stats[WQ_FUNC_STATS_SIZE];
+static unsigned long wq_func_stats_dropped;
+static DEFINE_SPINLOCK(wq_func_stats_lock);
+
+/*
+ * A bound workqueue whose works average more than this much cpu time
+ * over at least WQ_STATS_MIN_WORKS works is switched to cpu intensive
+ * mode.  0 disables it.
+ */
+#define WQ_STATS_MIN_WORKS	16
+static u32 wq_cpu_intensive_thresh_us;
+
+static bool wq_cpu_intensive(struct workqueue_struct *wq)
+{
+	return (wq->flags & WQ_CPU_INTENSIVE) ||
+		ACCESS_ONCE(wq->auto_cpu_intensive);
+}
+
+static void wq_stats_add(struct wq_stats *st, u64 lat, u64 exec, u64 cpu)
+{
+	st->nr_works++;
+	st->lat_total += lat;
+	st->lat_max = max(st->lat_max, lat);
+	st->exec_total += exec;
+	st->exec_max = max(st->exec_max, exec);
+	st->cpu_total += cpu;
+}
+
+static struct wq_func_stats *wq_func_stats_find(work_func_t func)
+{
+	unsigned long i = hash_ptr(func, WQ_FUNC_STATS_BITS);
+	int probe;
+
+	for (probe = 0; probe < WQ_FUNC_STATS_SIZE; probe++) {
+		struct wq_func_stats *fs = &wq_func_stats[i];
+
+		if (fs->func == func)
+			return fs;
+		if (!fs->func) {
+			fs->func = func;
+			return fs;
+		}
+		i = (i + 1) & (WQ_FUNC_STATS_SIZE - 1);
+	}
+	return NULL;
+}
+
+/**
+ * wq_stats_account - account a finished work item
+ * @cwq: cwq the work was executed from
+ * @work: the work, only its address is used
+ * @f: the work function
+ * @queued_at: work->queued_at sampled before execution
+ * @start: local_clock() right before @f was called
+ * @cpu_start: sum_exec_runtime of the worker right before @f was called
+ *
+ * CONTEXT:
+ * spin_lock_irq(gcwq->lock).
+ */
+static void wq_stats_account(struct cpu_workqueue_struct *cwq,
+			     struct work_struct *work, work_func_t f,
+			     u64 queued_at, u64 start, u64 cpu_start)
+{
+	struct workqueue_struct *wq = cwq->wq;
+	struct wq_func_stats *fs;
+	u64 now = local_clock();
+	u64 lat, exec, cpu;
+	u32 thresh;
+
+	/* queueing and execution can happen on different cpus */
+	lat = start > queued_at ? start - queued_at : 0;
+	exec = now > start ? now - start : 0;
+	cpu = current->se.sum_exec_runtime - cpu_start;
+
+	wq_stats_add(&cwq->stats, lat, exec, cpu);
+
+	spin_lock(&wq_func_stats_lock);
+	fs = wq_func_stats_find(f);
+	if (fs) {
+		fs->wq_name = wq->name;
+		wq_stats_add(&fs->stats, lat, exec, cpu);
+	} else
+		wq_func_stats_dropped++;
+	spin_unlock(&wq_func_stats_lock);
+
+	trace_workqueue_execute_stats(work, f, wq->name, lat, exec);
+
+	thresh = ACCESS_ONCE(wq_cpu_intensive_thresh_us);
+	if (!thresh || wq->flags & WQ_UNBOUND || wq_cpu_intensive(wq) ||
+	    cwq->stats.nr_works < WQ_STATS_MIN_WORKS)
+		return;
+
+	if (div64_u64(cwq->stats.cpu_total, cwq->stats.nr_works) >
+	    (u64)thresh * NSEC_PER_USEC) {
+		wq->auto_cpu_intensive = true;
+		printk(KERN_INFO "workqueue: %s averages more than %uus of cpu "
+		       "per work, treating it as WQ_CPU_INTENSIVE\n",
+		       wq->name, thresh);
+	}
+}
+#else
+static bool wq_cpu_intensive(struct workqueue_struct *wq)
+{
+	return wq->flags & WQ_CPU_INTENSIVE;
+}
+#endif
+
 /**
  * process_one_work - process single work
  * @worker: self
@@ -1829,10 +1980,13 @@ __acquires(&gcwq->lock)
 	struct cpu_workqueue_struct *cwq = get_work_cwq(work);
 	struct global_cwq *gcwq = cwq->gcwq;
 	struct hlist_head *bwh = busy_worker_head(gcwq, work);
-	bool cpu_intensive = cwq->wq->flags & WQ_CPU_INTENSIVE;
+	bool cpu_intensive = wq_cpu_intensive(cwq->wq);
 	work_func_t f = work->func;
 	int work_color;
 	struct worker *collision;
+#ifdef CONFIG_WQ_STATS
+	u64 queued_at = work->queued_at, start, cpu_start;
+#endif
 #ifdef CONFIG_LOCKDEP
 	/*
 	 * It is permissible to free the struct work_struct from
@@ -1896,6 +2050,10 @@ __acquires(&gcwq->lock)
 	lock_map_acquire_read(&cwq->wq->lockdep_map);
 	lock_map_acquire(&lockdep_map);
 	trace_workqueue_execute_start(work);
+#ifdef CONFIG_WQ_STATS
+	start = local_clock();
+	cpu_start = current->se.sum_exec_runtime;
+#endif
 	f(work);
 	/*
 	 * While we must be careful to not use "work" after this, the trace
@@ -1917,6 +2075,10 @@ __acquires(&gcwq->lock)
 
 	spin_lock_irq(&gcwq->lock);
 
+#ifdef CONFIG_WQ_STATS
+	wq_stats_account(cwq, work, f, queued_at, start, cpu_start);
+#endif
+
 	/* clear cpu intensive status */
 	if (unlikely(cpu_intensive))
 		worker_clr_flags(worker, WORKER_CPU_INTENSIVE);
@@ -3804,6 +3966,134 @@ out_unlock:
 }
 #endif /* CONFIG_FREEZER */
 
+#ifdef CONFIG_WQ_STATS
+static void wq_stats_print(struct seq_file *m, const char *name,
+			   struct wq_stats *st)
+{
+	u64 lat_avg = 0, exec_avg = 0;
+
+	if (st->nr_works) {
+		lat_avg = div64_u64(st->lat_total, st->nr_works);
+		exec_avg = div64_u64(st->exec_total, st->nr_works);
+	}
+
+	seq_printf(m, "%-32s %10llu %10llu %10llu %10llu %10llu %12llu\n",
+		   name, st->nr_works,
+		   div_u64(lat_avg, NSEC_PER_USEC),
+		   div_u64(st->lat_max, NSEC_PER_USEC),
+		   div_u64(exec_avg, NSEC_PER_USEC),
+		   div_u64(st->exec_max, NSEC_PER_USEC),
+		   div_u64(st->cpu_total, NSEC_PER_USEC));
+}
+
+static void wq_stats_header(struct seq_file *m, const char *what)
+{
+	seq_printf(m, "%-32s %10s %10s %10s %10s %10s %12s\n", what,
+		   "works", "lat_avg", "lat_max", "exec_avg", "exec_max",
+		   "cpu_total");
+}
+
+static int wq_stats_show(struct seq_file *m, void *unused)
+{
+	struct workqueue_struct *wq;
+	unsigned int cpu;
+
+	seq_printf(m, "# times in usecs, * = cpu intensive\n");
+	wq_stats_header(m, "# workqueue");
+
+	spin_lock(&workqueue_lock);
+	list_for_each_entry(wq, &workqueues, list) {
+		struct wq_stats sum = { };
+		char name[34];
+
+		for_each_cwq_cpu(cpu, wq) {
+			struct cpu_workqueue_struct *cwq = get_cwq(cpu, wq);
+			struct wq_stats *st = &cwq->stats;
+
+			spin_lock_irq(&cwq->gcwq->lock);
+			sum.nr_works += st->nr_works;
+			sum.lat_total += st->lat_total;
+			sum.lat_max = max(sum.lat_max, st->lat_max);
+			sum.exec_total += st->exec_total;
+			sum.exec_max = max(sum.exec_max, st->exec_max);
+			sum.cpu_total += st->cpu_total;
+			spin_unlock_irq(&cwq->gcwq->lock);
+		}
+
+		snprintf(name, sizeof(name), "%s%s", wq->name,
+			 wq_cpu_intensive(wq) ? "*" : "");
+		wq_stats_print(m, name, &sum);
+	}
+	spin_unlock(&workqueue_lock);
+
+	return 0;
+}
+
+static int wq_stats_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, wq_stats_show, NULL);
+}
+
+static const struct file_operations wq_stats_fops = {
+	.open		= wq_stats_open,
+	.read		= seq_read,
+	.llseek		= seq_lseek,
+	.release	= single_release,
+};
+
+static int wq_func_stats_show(struct seq_file *m, void *unused)
+{
+	int i;
+
+	seq_printf(m, "# times in usecs\n");
+	wq_stats_header(m, "# function");
+
+	spin_lock_irq(&wq_func_stats_lock);
+	for (i = 0; i < WQ_FUNC_STATS_SIZE; i++) {
+		struct wq_func_stats *fs = &wq_func_stats[i];
+		char name[KSYM_SYMBOL_LEN];
+
+		if (!fs->func)
+			continue;
+		snprintf(name, sizeof(name), "%pf", fs->func);
+		wq_stats_print(m, name, &fs->stats);
+	}
+	seq_printf(m, "# dropped: %lu\n", wq_func_stats_dropped);
+	spin_unlock_irq(&wq_func_stats_lock);
+
+	return 0;
+}
+
+static int wq_func_stats_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, wq_func_stats_show, NULL);
+}
+
+static const struct file_operations wq_func_stats_fops = {
+	.open		= wq_func_stats_open,
+	.read		= seq_read,
+	.llseek		= seq_lseek,
+	.release	= single_release,
+};
+
+static int __init wq_stats_debugfs_init(void)
+{
+	struct dentry *dir;
+
+	dir = debugfs_create_dir("workqueue", NULL);
+	if (!dir)
+		return -ENOMEM;
+
+	debugfs_create_file("stats", S_IRUGO, dir, NULL, &wq_stats_fops);
+	debugfs_create_file("functions", S_IRUGO, dir, NULL,
+			    &wq_func_stats_fops);
+	debugfs_create_u32("cpu_intensive_thresh_us", S_IRUGO | S_IWUSR, dir,
+			   &wq_cpu_intensive_thresh_us);
+	return 0;
+}
+late_initcall(wq_stats_debugfs_init);
+#endif /* CONFIG_WQ_STATS */
+
 static int __init init_workqueues(void)
 {
 	unsigned int cpu;
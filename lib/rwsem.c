@@ -7,6 +7,8 @@
 #include <linux/sched.h>
 #include <linux/init.h>
 #include <linux/module.h>
+#include <linux/lock_cstat.h>
+#include <linux/mcs_spinlock.h>
 
 /*
  * Initialize an rwsem:
@@ -24,6 +26,10 @@ void __init_rwsem(struct rw_semaphore *sem, const char *name,
 	sem->count = RWSEM_UNLOCKED_VALUE;
 	spin_lock_init(&sem->wait_lock);
 	INIT_LIST_HEAD(&sem->wait_list);
+#ifdef CONFIG_RWSEM_SPIN_ON_OWNER
+	sem->owner = NULL;
+	sem->spin_mlock = NULL;
+#endif
 }
 
 EXPORT_SYMBOL(__init_rwsem);
@@ -201,7 +207,7 @@ rwsem_down_failed_common(struct rw_semaphore *sem,
 	if (count == RWSEM_WAITING_BIAS)
 		sem = __rwsem_do_wake(sem, RWSEM_WAKE_NO_ACTIVE);
 	else if (count > RWSEM_WAITING_BIAS &&
-		 adjustment == -RWSEM_ACTIVE_WRITE_BIAS)
+		 (flags & RWSEM_WAITING_FOR_WRITE))
 		sem = __rwsem_do_wake(sem, RWSEM_WAKE_READ_OWNED);
 
 	spin_unlock_irq(&sem->wait_lock);
@@ -224,18 +230,110 @@ rwsem_down_failed_common(struct rw_semaphore *sem,
  */
 struct rw_semaphore __sched *rwsem_down_read_failed(struct rw_semaphore *sem)
 {
-	return rwsem_down_failed_common(sem, RWSEM_WAITING_FOR_READ,
-					-RWSEM_ACTIVE_READ_BIAS);
+	u64 start = lock_cstat_clock();
+
+	sem = rwsem_down_failed_common(sem, RWSEM_WAITING_FOR_READ,
+				       -RWSEM_ACTIVE_READ_BIAS);
+	lock_cstat_account(LOCK_CSTAT_RWSEM_READ, false, start);
+	return sem;
+}
+
+#ifdef CONFIG_RWSEM_SPIN_ON_OWNER
+/*
+ * Try to take the write lock without queueing, which is only possible
+ * when nobody holds it: count is 0, or only says that there are waiters.
+ */
+static inline int rwsem_try_write_lock_unqueued(struct rw_semaphore *sem)
+{
+	long old, count = ACCESS_ONCE(sem->count);
+
+	while (count == 0 || count == RWSEM_WAITING_BIAS) {
+		old = cmpxchg(&sem->count, count,
+			      count + RWSEM_ACTIVE_WRITE_BIAS);
+		if (old == count)
+			return 1;
+		count = old;
+	}
+	return 0;
+}
+
+/*
+ * Optimistic spinning for writers, the same heuristic as the mutex one:
+ * while the writer holding the lock runs on another cpu it is likely to
+ * release it soon, and spinning is cheaper than sleeping and being woken.
+ * Spinners queue on an MCS lock so that only one of them at a time polls
+ * the count and the owner.  A reader-owned lock has no owner to watch; we
+ * keep trying until we are asked to reschedule.
+ *
+ * This steals the lock from the queued waiters, which is fine: whoever
+ * releases it later still sees them in the count and wakes them.
+ */
+static int rwsem_optimistic_spin(struct rw_semaphore *sem)
+{
+	struct task_struct *owner;
+	struct mcs_spinlock node;
+	int taken = 0;
+
+	preempt_disable();
+	if (need_resched())
+		goto out;
+
+	mcs_spin_lock(&sem->spin_mlock, &node);
+	for (;;) {
+		owner = ACCESS_ONCE(sem->owner);
+		if (owner && !rwsem_spin_on_owner(sem, owner))
+			break;
+
+		if (rwsem_try_write_lock_unqueued(sem)) {
+			taken = 1;
+			break;
+		}
+
+		/* See the comment in __mutex_lock_common() */
+		if (!owner && (need_resched() || rt_task(current)))
+			break;
+
+		arch_mutex_cpu_relax();
+	}
+	mcs_spin_unlock(&sem->spin_mlock, &node);
+out:
+	preempt_enable();
+	return taken;
 }
 
 /*
  * wait for the write lock to be granted
+ * - spin first if the owner is running; our active bias has to go away
+ *   for that, so that the lock can be seen free and taken by cmpxchg
  */
 struct rw_semaphore __sched *rwsem_down_write_failed(struct rw_semaphore *sem)
 {
-	return rwsem_down_failed_common(sem, RWSEM_WAITING_FOR_WRITE,
-					-RWSEM_ACTIVE_WRITE_BIAS);
+	u64 start = lock_cstat_clock();
+
+	rwsem_atomic_update(-RWSEM_ACTIVE_WRITE_BIAS, sem);
+	if (rwsem_optimistic_spin(sem)) {
+		lock_cstat_account(LOCK_CSTAT_RWSEM_WRITE, true, start);
+		return sem;
+	}
+
+	sem = rwsem_down_failed_common(sem, RWSEM_WAITING_FOR_WRITE, 0);
+	lock_cstat_account(LOCK_CSTAT_RWSEM_WRITE, false, start);
+	return sem;
 }
+#else
+/*
+ * wait for the write lock to be granted
+ */
+struct rw_semaphore __sched *rwsem_down_write_failed(struct rw_semaphore *sem)
+{
+	u64 start = lock_cstat_clock();
+
+	sem = rwsem_down_failed_common(sem, RWSEM_WAITING_FOR_WRITE,
+				       -RWSEM_ACTIVE_WRITE_BIAS);
+	lock_cstat_account(LOCK_CSTAT_RWSEM_WRITE, false, start);
+	return sem;
+}
+#endif
 
 /*
  * handle waking up a waiter on the semaphore
@@ -14,6 +14,10 @@
 #include <linux/backing-dev.h>
 #include <linux/sysctl.h>
 #include <linux/sysfs.h>
+#include <linux/kthread.h>
+#include <linux/freezer.h>
+#include <linux/debugfs.h>
+#include <linux/seq_file.h>
 #include "internal.h"
 
 #define CREATE_TRACE_POINTS
@@ -31,6 +35,7 @@ struct compact_control {
 	struct list_head migratepages;	/* List of pages being migrated */
 	unsigned long nr_freepages;	/* Number of isolated free pages */
 	unsigned long nr_migratepages;	/* Number of pages to migrate */
+	unsigned long nr_migrated;	/* Number of pages migrated so far */
 	unsigned long free_pfn;		/* isolate_freepages search base */
 	unsigned long migrate_pfn;	/* isolate_migratepages search base */
 	bool sync;			/* Synchronous migration */
@@ -581,6 +586,7 @@ static int compact_zone(struct zone *zone, struct compact_control *cc)
 		update_nr_listpages(cc);
 		nr_remaining = cc->nr_migratepages;
 
+		cc->nr_migrated += nr_migrate - nr_remaining;
 		count_vm_event(COMPACTBLOCKS);
 		count_vm_events(COMPACTPAGES, nr_migrate - nr_remaining);
 		if (nr_remaining)
@@ -627,6 +633,27 @@ static unsigned long compact_zone_order(struct zone *zone,
 
 int sysctl_extfrag_threshold = 500;
 
+static DEFINE_SPINLOCK(kcompactd_stats_lock);
+static struct {
+	unsigned long wakeups;
+	unsigned long runs;		/* zones compacted by kcompactd */
+	unsigned long successes;	/* runs leaving a free block */
+	unsigned long migrated;
+	unsigned long direct_stalls;
+	u64 direct_stall_ns;
+} kcompactd_stats;
+
+static void account_direct_stall(u64 start)
+{
+	u64 stall = local_clock() - start;
+	unsigned long flags;
+
+	spin_lock_irqsave(&kcompactd_stats_lock, flags);
+	kcompactd_stats.direct_stalls++;
+	kcompactd_stats.direct_stall_ns += stall;
+	spin_unlock_irqrestore(&kcompactd_stats_lock, flags);
+}
+
 /**
  * try_to_compact_pages - Direct compact to satisfy a high-order allocation
  * @zonelist: The zonelist used for the current allocation
@@ -647,6 +674,7 @@ unsigned long try_to_compact_pages(struct zonelist *zonelist,
 	struct zoneref *z;
 	struct zone *zone;
 	int rc = COMPACT_SKIPPED;
+	u64 start;
 
 	/*
 	 * Check whether it is worth even starting compaction. The order check is
@@ -657,6 +685,7 @@ unsigned long try_to_compact_pages(struct zonelist *zonelist,
 		return rc;
 
 	count_vm_event(COMPACTSTALL);
+	start = local_clock();
 
 	/* Compact each zone in the list */
 	for_each_zone_zonelist_nodemask(zone, z, zonelist, high_zoneidx,
@@ -671,6 +700,7 @@ unsigned long try_to_compact_pages(struct zonelist *zonelist,
 			break;
 	}
 
+	account_direct_stall(start);
 	return rc;
 }
 
@@ -743,6 +773,300 @@ int sysctl_extfrag_handler(struct ctl_table *table, int write,
 	return 0;
 }
 
+/*
+ * Background compaction
+ *
+ * Each node has a kcompactd thread.  kswapd wakes it when it goes to sleep
+ * after reclaiming for a high-order allocation, and every
+ * compact_proactive_secs it wakes up by itself to look after the first
+ * order above PAGE_ALLOC_COSTLY_ORDER, the 64k blocks ion and kgsl keep
+ * asking for.  It compacts the zones whose fragmentation index says an
+ * allocation of that order would fail for fragmentation rather than for
+ * lack of memory, asynchronously and at the lowest priority, so that the
+ * allocation finds the block free instead of stalling in direct
+ * compaction.
+ */
+#define KCOMPACTD_PROACTIVE_ORDER	(PAGE_ALLOC_COSTLY_ORDER + 1)
+
+int sysctl_compact_proactive_secs = 10;
+
+static bool kcompactd_node_suitable(pg_data_t *pgdat, int order,
+				    int classzone_idx)
+{
+	int zoneid;
+
+	for (zoneid = 0; zoneid <= classzone_idx; zoneid++) {
+		struct zone *zone = &pgdat->node_zones[zoneid];
+
+		if (!populated_zone(zone))
+			continue;
+		if (compaction_suitable(zone, order) == COMPACT_CONTINUE)
+			return true;
+	}
+
+	return false;
+}
+
+static void kcompactd_do_work(pg_data_t *pgdat, int order, int classzone_idx,
+			      int migratetype)
+{
+	unsigned long runs = 0, successes = 0, migrated = 0;
+	unsigned long flags;
+	int zoneid;
+
+	for (zoneid = 0; zoneid <= classzone_idx; zoneid++) {
+		struct zone *zone = &pgdat->node_zones[zoneid];
+		struct compact_control cc = {
+			.nr_freepages = 0,
+			.nr_migratepages = 0,
+			.order = order,
+			.migratetype = migratetype,
+			.zone = zone,
+			.sync = false,
+		};
+		int status;
+
+		if (kthread_should_stop())
+			break;
+		if (!populated_zone(zone))
+			continue;
+		if (compaction_deferred(zone))
+			continue;
+		if (compaction_suitable(zone, order) != COMPACT_CONTINUE)
+			continue;
+
+		INIT_LIST_HEAD(&cc.freepages);
+		INIT_LIST_HEAD(&cc.migratepages);
+
+		status = compact_zone(zone, &cc);
+
+		runs++;
+		migrated += cc.nr_migrated;
+		if (zone_watermark_ok(zone, order, low_wmark_pages(zone),
+				      0, 0)) {
+			successes++;
+			zone->compact_considered = 0;
+			zone->compact_defer_shift = 0;
+		} else if (status == COMPACT_COMPLETE) {
+			/* Scanned the whole zone, back off as direct does */
+			defer_compaction(zone);
+		}
+
+		VM_BUG_ON(!list_empty(&cc.freepages));
+		VM_BUG_ON(!list_empty(&cc.migratepages));
+	}
+
+	spin_lock_irqsave(&kcompactd_stats_lock, flags);
+	kcompactd_stats.wakeups++;
+	kcompactd_stats.runs += runs;
+	kcompactd_stats.successes += successes;
+	kcompactd_stats.migrated += migrated;
+	spin_unlock_irqrestore(&kcompactd_stats_lock, flags);
+}
+
+static bool kcompactd_work_requested(pg_data_t *pgdat)
+{
+	return pgdat->kcompactd_max_order > 0 || kthread_should_stop();
+}
+
+static void kcompactd_timer_fn(unsigned long data)
+{
+	pg_data_t *pgdat = (pg_data_t *)data;
+
+	wake_up_interruptible(&pgdat->kcompactd_wait);
+}
+
+static int kcompactd(void *p)
+{
+	pg_data_t *pgdat = p;
+	const struct cpumask *cpumask = cpumask_of_node(pgdat->node_id);
+	struct timer_list timer;
+
+	if (!cpumask_empty(cpumask))
+		set_cpus_allowed_ptr(current, cpumask);
+	set_user_nice(current, 19);
+	set_freezable();
+
+	/*
+	 * The proactive check is not worth waking an idle CPU for, so it
+	 * runs off a deferrable timer and waits for the next real wakeup.
+	 */
+	setup_deferrable_timer_on_stack(&timer, kcompactd_timer_fn,
+					(unsigned long)pgdat);
+
+	while (!kthread_should_stop()) {
+		unsigned long secs = sysctl_compact_proactive_secs;
+		int order, classzone_idx, migratetype;
+
+		if (secs)
+			mod_timer(&timer, jiffies + secs * HZ);
+		else
+			del_timer(&timer);
+		wait_event_freezable(pgdat->kcompactd_wait,
+				kcompactd_work_requested(pgdat) ||
+				(secs && !timer_pending(&timer)));
+		if (kthread_should_stop())
+			break;
+
+		order = pgdat->kcompactd_max_order;
+		classzone_idx = pgdat->kcompactd_classzone_idx;
+		pgdat->kcompactd_max_order = 0;
+		pgdat->kcompactd_classzone_idx = pgdat->nr_zones - 1;
+
+		/* The allocations that stall are the kernel's own */
+		migratetype = MIGRATE_UNMOVABLE;
+
+		/*
+		 * Timed out: proactive check.  Any free block of the order
+		 * will do here, and asking for a movable one lets the scan
+		 * stop as soon as one is made instead of going through the
+		 * whole zone looking for an unmovable one.
+		 */
+		if (!order) {
+			order = KCOMPACTD_PROACTIVE_ORDER;
+			classzone_idx = pgdat->nr_zones - 1;
+			migratetype = MIGRATE_MOVABLE;
+			if (!kcompactd_node_suitable(pgdat, order,
+						     classzone_idx))
+				continue;
+		}
+
+		kcompactd_do_work(pgdat, order, classzone_idx, migratetype);
+	}
+
+	del_timer_sync(&timer);
+	destroy_timer_on_stack(&timer);
+	return 0;
+}
+
+/**
+ * wakeup_kcompactd - ask kcompactd to make a high-order block available
+ * @pgdat: node to compact
+ * @order: order of the block
+ * @classzone_idx: highest zone to compact
+ *
+ * Only wakes kcompactd if compaction is likely to help in one of the zones.
+ */
+void wakeup_kcompactd(pg_data_t *pgdat, int order, int classzone_idx)
+{
+	if (!order)
+		return;
+
+	if (pgdat->kcompactd_max_order < order)
+		pgdat->kcompactd_max_order = order;
+	if (pgdat->kcompactd_classzone_idx > classzone_idx)
+		pgdat->kcompactd_classzone_idx = classzone_idx;
+
+	if (!waitqueue_active(&pgdat->kcompactd_wait))
+		return;
+	if (!kcompactd_node_suitable(pgdat, order, classzone_idx))
+		return;
+
+	wake_up_interruptible(&pgdat->kcompactd_wait);
+}
+
+/*
+ * Started at boot and on memory hot-add, like kswapd.
+ */
+int kcompactd_run(int nid)
+{
+	pg_data_t *pgdat = NODE_DATA(nid);
+
+	if (pgdat->kcompactd)
+		return 0;
+
+	pgdat->kcompactd_max_order = 0;
+	pgdat->kcompactd_classzone_idx = pgdat->nr_zones - 1;
+	pgdat->kcompactd = kthread_run(kcompactd, pgdat, "kcompactd%d", nid);
+	if (IS_ERR(pgdat->kcompactd)) {
+		printk(KERN_ERR "Failed to start kcompactd on node %d\n", nid);
+		pgdat->kcompactd = NULL;
+		return -1;
+	}
+	return 0;
+}
+
+/*
+ * Called by memory hotplug when all memory in a node is offlined.  Caller must
+ * hold lock_memory_hotplug().
+ */
+void kcompactd_stop(int nid)
+{
+	struct task_struct *kcompactd = NODE_DATA(nid)->kcompactd;
+
+	if (kcompactd) {
+		kthread_stop(kcompactd);
+		NODE_DATA(nid)->kcompactd = NULL;
+	}
+}
+
+#ifdef CONFIG_DEBUG_FS
+static int kcompactd_stats_show(struct seq_file *m, void *unused)
+{
+	unsigned long flags, successes, stalls;
+	u64 stall_avg, avoided;
+
+	spin_lock_irqsave(&kcompactd_stats_lock, flags);
+	successes = kcompactd_stats.successes;
+	stalls = kcompactd_stats.direct_stalls;
+	stall_avg = kcompactd_stats.direct_stall_ns;
+	if (stalls)
+		do_div(stall_avg, stalls);
+	/*
+	 * Every zone kcompactd left with a free block of the order is a
+	 * direct compaction that did not have to happen: estimate the time
+	 * saved at the average direct compaction stall.
+	 */
+	avoided = stall_avg * successes;
+
+	seq_printf(m, "wakeups:               %lu\n", kcompactd_stats.wakeups);
+	seq_printf(m, "zones_compacted:       %lu\n", kcompactd_stats.runs);
+	seq_printf(m, "successes:             %lu\n", successes);
+	seq_printf(m, "pages_migrated:        %lu\n", kcompactd_stats.migrated);
+	seq_printf(m, "direct_stalls:         %lu\n", stalls);
+	seq_printf(m, "direct_stall_ns:       %llu\n",
+		   (unsigned long long)kcompactd_stats.direct_stall_ns);
+	seq_printf(m, "direct_stall_avg_ns:   %llu\n",
+		   (unsigned long long)stall_avg);
+	seq_printf(m, "stall_avoided_est_ns:  %llu\n",
+		   (unsigned long long)avoided);
+	spin_unlock_irqrestore(&kcompactd_stats_lock, flags);
+
+	return 0;
+}
+
+static int kcompactd_stats_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, kcompactd_stats_show, NULL);
+}
+
+static const struct file_operations kcompactd_stats_fops = {
+	.open		= kcompactd_stats_open,
+	.read		= seq_read,
+	.llseek		= seq_lseek,
+	.release	= single_release,
+};
+
+static void kcompactd_debugfs_init(void)
+{
+	debugfs_create_file("kcompactd", S_IRUGO, NULL, NULL,
+			    &kcompactd_stats_fops);
+}
+#else
+static inline void kcompactd_debugfs_init(void) {}
+#endif
+
+static int __init kcompactd_init(void)
+{
+	int nid;
+
+	for_each_node_state(nid, N_HIGH_MEMORY)
+		kcompactd_run(nid);
+	kcompactd_debugfs_init();
+	return 0;
+}
+module_init(kcompactd_init)
+
 #if defined(CONFIG_SYSFS) && defined(CONFIG_NUMA)
 ssize_t sysfs_compact_node(struct sys_device *dev,
 			struct sysdev_attribute *attr,
@@ -501,7 +501,10 @@ int __add_to_page_cache_lru(struct page *page, struct address_space *mapping,
 
 	ret = add_to_page_cache(page, mapping, offset, gfp_mask);
 	if (ret == 0) {
-		if (page_is_file_cache(page))
+		if (page_is_file_cache(page) &&
+		    workingset_refault(mapping, offset))
+			lru_cache_add_lru(page, LRU_ACTIVE_FILE);
+		else if (page_is_file_cache(page))
 			lru_cache_add_file_tail(page, tail);
 		else
 			lru_cache_add_anon(page);
@@ -299,7 +299,7 @@ madvise_behavior_valid(int behavior)
 	case MADV_MERGEABLE:
 	case MADV_UNMERGEABLE:
 #endif
-#ifdef CONFIG_TRANSPARENT_HUGEPAGE
+#if defined(CONFIG_TRANSPARENT_HUGEPAGE) || defined(CONFIG_ANON_LARGE_PAGES)
 	case MADV_HUGEPAGE:
 	case MADV_NOHUGEPAGE:
 #endif
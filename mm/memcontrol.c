@@ -2079,6 +2079,25 @@ static void refill_stock(struct mem_cgroup *mem, unsigned int nr_pages)
 	put_cpu_var(memcg_stock);
 }
 
+/*
+ * Returns an uncharged page to the local stock instead of the res_counter,
+ * so that a cpu freeing and allocating pages of the same memcg does not
+ * touch the res_counter at all.  Only tops up a stock that already caches
+ * @mem, and no further than CHARGE_BATCH.
+ */
+static bool uncharge_to_stock(struct mem_cgroup *mem)
+{
+	struct memcg_stock_pcp *stock = &get_cpu_var(memcg_stock);
+	bool ret = false;
+
+	if (stock->cached == mem && stock->nr_pages < CHARGE_BATCH) {
+		stock->nr_pages++;
+		ret = true;
+	}
+	put_cpu_var(memcg_stock);
+	return ret;
+}
+
 /*
  * Tries to drain stocked charges in other cpus. This function is asynchronous
  * and just put a work per cpu for draining localy on each cpu. Caller can
@@ -2988,6 +3007,13 @@ static void mem_cgroup_do_uncharge(struct mem_cgroup *mem,
 		batch->memsw_nr_pages++;
 	return;
 direct_uncharge:
+	/*
+	 * The stock holds memsw charges as well, and must not sit on
+	 * charges that a memcg under OOM is waiting for.
+	 */
+	if (nr_pages == 1 && uncharge_memsw == do_swap_account &&
+	    !atomic_read(&mem->oom_lock) && uncharge_to_stock(mem))
+		return;
 	res_counter_uncharge(&mem->res, nr_pages * PAGE_SIZE);
 	if (uncharge_memsw)
 		res_counter_uncharge(&mem->memsw, nr_pages * PAGE_SIZE);
@@ -3657,7 +3683,12 @@ unsigned long mem_cgroup_soft_limit_reclaim(struct zone *zone, int order,
 	unsigned long long excess;
 	unsigned long nr_scanned;
 
-	if (order > 0)
+	/*
+	 * Reclaiming from the groups above their soft limit does not
+	 * help contiguity, but compaction can make use of the order-0
+	 * pages for the small orders that kswapd is commonly woken for.
+	 */
+	if (order > PAGE_ALLOC_COSTLY_ORDER)
 		return 0;
 
 	mctz = soft_limit_tree_node_zone(zone_to_nid(zone), zone_idx(zone));
@@ -4342,7 +4373,8 @@ static int mem_cgroup_swappiness_write(struct cgroup *cgrp, struct cftype *cft,
 	struct mem_cgroup *memcg = mem_cgroup_from_cont(cgrp);
 	struct mem_cgroup *parent;
 
-	if (val > 100)
+	/* Above 100, anon is preferred over file, e.g. for swap on zram */
+	if (val > 200)
 		return -EINVAL;
 
 	if (cgrp->parent == NULL)
@@ -57,6 +57,7 @@
 #include <linux/swapops.h>
 #include <linux/elf.h>
 #include <linux/gfp.h>
+#include <linux/prezero.h>
 
 #include <asm/io.h>
 #include <asm/pgalloc.h>
@@ -2708,7 +2709,10 @@ gotten:
 		goto oom;
 
 	if (is_zero_pfn(pte_pfn(orig_pte))) {
-		new_page = alloc_zeroed_user_highpage_movable(vma, address);
+		new_page = alloc_prezeroed_page(vma);
+		if (!new_page)
+			new_page = alloc_zeroed_user_highpage_movable(vma,
+								      address);
 		if (!new_page)
 			goto oom;
 	} else {
@@ -2952,8 +2956,8 @@ static int do_swap_page(struct mm_struct *mm, struct vm_area_struct *vma,
 	page = lookup_swap_cache(entry);
 	if (!page) {
 		grab_swap_token(mm); /* Contend for token _before_ read-in */
-		page = swapin_readahead(entry,
-					GFP_HIGHUSER_MOVABLE, vma, address);
+		page = swap_vma_readahead(entry, GFP_HIGHUSER_MOVABLE,
+					  vma, address, pmd);
 		if (!page) {
 			/*
 			 * Back out if somebody else faulted in this pte
@@ -3132,6 +3136,148 @@ static inline int check_stack_guard_page(struct vm_area_struct *vma, unsigned lo
 	return 0;
 }
 
+#ifdef CONFIG_ANON_LARGE_PAGES
+/*
+ * Anonymous large pages: 0 never, 1 only in MADV_HUGEPAGE regions,
+ * 2 in all private anonymous memory.
+ */
+int sysctl_anon_large_pages __read_mostly = 1;
+
+int hugepage_madvise(struct vm_area_struct *vma,
+		     unsigned long *vm_flags, int advice)
+{
+	switch (advice) {
+	case MADV_HUGEPAGE:
+		*vm_flags &= ~VM_NOHUGEPAGE;
+		*vm_flags |= VM_HUGEPAGE;
+		break;
+	case MADV_NOHUGEPAGE:
+		*vm_flags &= ~VM_HUGEPAGE;
+		*vm_flags |= VM_NOHUGEPAGE;
+		break;
+	}
+	return 0;
+}
+
+static bool anon_large_vma(struct vm_area_struct *vma, unsigned long haddr)
+{
+	if (vma->vm_ops || !(vma->vm_flags & VM_WRITE) ||
+	    (vma->vm_flags & VM_NOHUGEPAGE))
+		return false;
+	if (!sysctl_anon_large_pages ||
+	    (sysctl_anon_large_pages == 1 && !(vma->vm_flags & VM_HUGEPAGE)))
+		return false;
+	return haddr >= vma->vm_start && haddr + LARGE_PTE_SIZE <= vma->vm_end;
+}
+
+/*
+ * Back the whole LARGE_PTE_SIZE block around @address with one physically
+ * contiguous allocation, so that the architecture can map it with a single
+ * TLB entry.  The allocation is split and every page is mapped on its own,
+ * so the rest of the VM treats them like any other anonymous page; the
+ * architecture breaks the large mapping up again when one of the ptes
+ * changes.  Returns false if the caller should fault in a single page.
+ */
+static bool do_anonymous_large_page(struct mm_struct *mm,
+		struct vm_area_struct *vma, unsigned long address, pmd_t *pmd)
+{
+	unsigned long haddr = address & LARGE_PTE_MASK;
+	int order = LARGE_PTE_SHIFT - PAGE_SHIFT;
+	struct page *page;
+	pte_t *page_table;
+	spinlock_t *ptl;
+	int i, charged;
+
+	if (!anon_large_vma(vma, haddr))
+		return false;
+
+	/* Only empty blocks, this is no place to collapse existing pages */
+	page_table = pte_offset_map(pmd, haddr);
+	for (i = 0; i < LARGE_PTE_NR; i++)
+		if (!pte_none(page_table[i]))
+			break;
+	pte_unmap(page_table);
+	if (i < LARGE_PTE_NR)
+		return false;
+
+	page = alloc_pages_vma(GFP_HIGHUSER_MOVABLE | __GFP_NORETRY |
+			       __GFP_NOWARN, order, vma, haddr, numa_node_id());
+	if (!page) {
+		count_vm_event(ANON_LARGE_FALLBACK);
+		return false;
+	}
+	split_page(page, order);
+
+	for (charged = 0; charged < LARGE_PTE_NR; charged++) {
+		struct page *p = page + charged;
+
+		clear_user_highpage(p, haddr + charged * PAGE_SIZE);
+		__SetPageUptodate(p);
+		if (mem_cgroup_newpage_charge(p, mm, GFP_KERNEL))
+			goto release;
+	}
+
+	page_table = pte_offset_map_lock(mm, pmd, haddr, &ptl);
+	for (i = 0; i < LARGE_PTE_NR; i++) {
+		if (!pte_none(page_table[i])) {
+			pte_unmap_unlock(page_table, ptl);
+			goto release;
+		}
+	}
+
+	for (i = 0; i < LARGE_PTE_NR; i++) {
+		unsigned long addr = haddr + i * PAGE_SIZE;
+		pte_t entry;
+
+		entry = pte_mkwrite(pte_mkdirty(mk_pte(page + i,
+						       vma->vm_page_prot)));
+		inc_mm_counter_fast(mm, MM_ANONPAGES);
+		page_add_new_anon_rmap(page + i, vma, addr);
+		set_pte_at(mm, addr, page_table + i, entry);
+		update_mmu_cache(vma, addr, page_table + i);
+	}
+	make_large_pte(vma, haddr, page_table);
+	pte_unmap_unlock(page_table, ptl);
+	count_vm_event(ANON_LARGE_ALLOC);
+	return true;
+
+release:
+	while (charged--)
+		mem_cgroup_uncharge_page(page + charged);
+	for (i = 0; i < LARGE_PTE_NR; i++)
+		page_cache_release(page + i);
+	count_vm_event(ANON_LARGE_FALLBACK);
+	return false;
+}
+
+/*
+ * Called with the pte lock held after the access flags of @pte were
+ * updated: once all the ptes of a block are young again, for example
+ * after reclaim aged them, map the block large again.
+ */
+static void anon_large_refold(struct vm_area_struct *vma,
+			      unsigned long address, pte_t *pte)
+{
+	unsigned long haddr = address & LARGE_PTE_MASK;
+
+	if (!anon_large_vma(vma, haddr))
+		return;
+	if (make_large_pte(vma, haddr, pte - ((address - haddr) >> PAGE_SHIFT)))
+		count_vm_event(ANON_LARGE_FOLD);
+}
+#else
+static inline bool do_anonymous_large_page(struct mm_struct *mm,
+		struct vm_area_struct *vma, unsigned long address, pmd_t *pmd)
+{
+	return false;
+}
+
+static inline void anon_large_refold(struct vm_area_struct *vma,
+				     unsigned long address, pte_t *pte)
+{
+}
+#endif /* CONFIG_ANON_LARGE_PAGES */
+
 /*
  * We enter with non-exclusive mmap_sem (to exclude vma changes,
  * but allow concurrent faults), and pte mapped but not yet locked.
@@ -3164,7 +3310,11 @@ static int do_anonymous_page(struct mm_struct *mm, struct vm_area_struct *vma,
 	/* Allocate our own private page. */
 	if (unlikely(anon_vma_prepare(vma)))
 		goto oom;
-	page = alloc_zeroed_user_highpage_movable(vma, address);
+	if (do_anonymous_large_page(mm, vma, address, pmd))
+		return 0;
+	page = alloc_prezeroed_page(vma);
+	if (!page)
+		page = alloc_zeroed_user_highpage_movable(vma, address);
 	if (!page)
 		goto oom;
 	__SetPageUptodate(page);
@@ -3480,6 +3630,7 @@ int handle_pte_fault(struct mm_struct *mm,
 	entry = pte_mkyoung(entry);
 	if (ptep_set_access_flags(vma, address, pte, entry, flags & FAULT_FLAG_WRITE)) {
 		update_mmu_cache(vma, address, pte);
+		anon_large_refold(vma, address, pte);
 	} else {
 		/*
 		 * This is needed only for protection faults but the arch code
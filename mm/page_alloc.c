@@ -600,10 +600,39 @@ static inline int free_pages_check(struct page *page)
 	return 0;
 }
 
+#ifdef CONFIG_ZONE_LOCK_STATS
+static inline void zone_lock_acquired(struct zone *zone)
+{
+	zone->lock_stat.acquired = local_clock();
+}
+
+static inline void zone_lock_releasing(struct zone *zone)
+{
+	struct zone_lock_stat *st = &zone->lock_stat;
+	u64 hold = local_clock() - st->acquired;
+
+	st->nr++;
+	st->hold_total += hold;
+	if (hold > st->hold_max)
+		st->hold_max = hold;
+}
+#else
+static inline void zone_lock_acquired(struct zone *zone) {}
+static inline void zone_lock_releasing(struct zone *zone) {}
+#endif
+
+static inline struct per_cpu_pages *pcp_order(struct per_cpu_pageset *pset,
+					      int order)
+{
+	if (likely(order == 0))
+		return &pset->pcp;
+	return &pset->pcp_high[order - 1];
+}
+
 /*
  * Frees a number of pages from the PCP lists
  * Assumes all pages on list are in same zone, and of same order.
- * count is the number of pages to free.
+ * count is the number of pages, or blocks of @order, to free.
  *
  * If the zone was previously in an "all pages pinned" state then look to
  * see if this freeing clears that state.
@@ -612,13 +641,14 @@ static inline int free_pages_check(struct page *page)
  * pinned" detection logic.
  */
 static void free_pcppages_bulk(struct zone *zone, int count,
-					struct per_cpu_pages *pcp)
+					struct per_cpu_pages *pcp, int order)
 {
 	int migratetype = 0;
 	int batch_free = 0;
 	int to_free = count;
 
 	spin_lock(&zone->lock);
+	zone_lock_acquired(zone);
 	zone->all_unreclaimable = 0;
 	zone->pages_scanned = 0;
 
@@ -649,11 +679,13 @@ static void free_pcppages_bulk(struct zone *zone, int count,
 			/* must delete as __free_one_page list manipulates */
 			list_del(&page->lru);
 			/* MIGRATE_MOVABLE list may include MIGRATE_RESERVEs */
-			__free_one_page(page, zone, 0, page_private(page));
-			trace_mm_page_pcpu_drain(page, 0, page_private(page));
+			__free_one_page(page, zone, order, page_private(page));
+			trace_mm_page_pcpu_drain(page, order,
+						 page_private(page));
 		} while (--to_free && --batch_free && !list_empty(list));
 	}
-	__mod_zone_page_state(zone, NR_FREE_PAGES, count);
+	__mod_zone_page_state(zone, NR_FREE_PAGES, count << order);
+	zone_lock_releasing(zone);
 	spin_unlock(&zone->lock);
 }
 
@@ -661,14 +693,44 @@ static void free_one_page(struct zone *zone, struct page *page, int order,
 				int migratetype)
 {
 	spin_lock(&zone->lock);
+	zone_lock_acquired(zone);
 	zone->all_unreclaimable = 0;
 	zone->pages_scanned = 0;
 
 	__free_one_page(page, zone, order, migratetype);
 	__mod_zone_page_state(zone, NR_FREE_PAGES, 1 << order);
+	zone_lock_releasing(zone);
 	spin_unlock(&zone->lock);
 }
 
+/*
+ * Free a block of order 1 to PCP_MAX_ORDER to this cpu's lists for its
+ * order.  Called with interrupts disabled.
+ */
+static void free_pcp_high(struct zone *zone, struct page *page, int order,
+			  int migratetype)
+{
+	struct per_cpu_pages *pcp;
+
+	/* The buddy allocator does this on free, the pcp lists must too */
+	if (unlikely(PageCompound(page)))
+		if (unlikely(destroy_compound_page(page, order)))
+			return;
+
+	/* RESERVE goes on the movable list, as in free_hot_cold_page() */
+	if (migratetype >= MIGRATE_PCPTYPES)
+		migratetype = MIGRATE_MOVABLE;
+	set_page_private(page, migratetype);
+
+	pcp = pcp_order(this_cpu_ptr(zone->pageset), order);
+	list_add(&page->lru, &pcp->lists[migratetype]);
+	pcp->count++;
+	if (pcp->count >= pcp->high) {
+		free_pcppages_bulk(zone, pcp->batch, pcp, order);
+		pcp->count -= pcp->batch;
+	}
+}
+
 static bool free_pages_prepare(struct page *page, unsigned int order)
 {
 	int i;
@@ -698,17 +760,22 @@ static bool free_pages_prepare(struct page *page, unsigned int order)
 static void __free_pages_ok(struct page *page, unsigned int order)
 {
 	unsigned long flags;
+	int migratetype;
 	int wasMlocked = __TestClearPageMlocked(page);
 
 	if (!free_pages_prepare(page, order))
 		return;
 
+	migratetype = get_pageblock_migratetype(page);
 	local_irq_save(flags);
 	if (unlikely(wasMlocked))
 		free_page_mlock(page);
 	__count_vm_events(PGFREE, 1 << order);
-	free_one_page(page_zone(page), page, order,
-					get_pageblock_migratetype(page));
+	/* ISOLATE pages go straight back, they are being offlined */
+	if (order <= PCP_MAX_ORDER && migratetype != MIGRATE_ISOLATE)
+		free_pcp_high(page_zone(page), page, order, migratetype);
+	else
+		free_one_page(page_zone(page), page, order, migratetype);
 	local_irq_restore(flags);
 }
 
@@ -1047,6 +1114,7 @@ static int rmqueue_bulk(struct zone *zone, unsigned int order,
 	int i;
 	
 	spin_lock(&zone->lock);
+	zone_lock_acquired(zone);
 	for (i = 0; i < count; ++i) {
 		struct page *page = __rmqueue(zone, order, migratetype);
 		if (unlikely(page == NULL))
@@ -1069,6 +1137,7 @@ static int rmqueue_bulk(struct zone *zone, unsigned int order,
 		list = &page->lru;
 	}
 	__mod_zone_page_state(zone, NR_FREE_PAGES, -(i << order));
+	zone_lock_releasing(zone);
 	spin_unlock(&zone->lock);
 	return i;
 }
@@ -1092,7 +1161,7 @@ void drain_zone_pages(struct zone *zone, struct per_cpu_pages *pcp)
 		to_drain = pcp->batch;
 	else
 		to_drain = pcp->count;
-	free_pcppages_bulk(zone, to_drain, pcp);
+	free_pcppages_bulk(zone, to_drain, pcp, 0);
 	pcp->count -= to_drain;
 	local_irq_restore(flags);
 }
@@ -1113,14 +1182,18 @@ static void drain_pages(unsigned int cpu)
 	for_each_populated_zone(zone) {
 		struct per_cpu_pageset *pset;
 		struct per_cpu_pages *pcp;
+		int order;
 
 		local_irq_save(flags);
 		pset = per_cpu_ptr(zone->pageset, cpu);
 
-		pcp = &pset->pcp;
-		if (pcp->count) {
-			free_pcppages_bulk(zone, pcp->count, pcp);
-			pcp->count = 0;
+		for (order = 0; order <= PCP_MAX_ORDER; order++) {
+			pcp = pcp_order(pset, order);
+			if (pcp->count) {
+				free_pcppages_bulk(zone, pcp->count, pcp,
+						   order);
+				pcp->count = 0;
+			}
 		}
 		local_irq_restore(flags);
 	}
@@ -1222,7 +1295,7 @@ void free_hot_cold_page(struct page *page, int cold)
 		list_add(&page->lru, &pcp->lists[migratetype]);
 	pcp->count++;
 	if (pcp->count >= pcp->high) {
-		free_pcppages_bulk(zone, pcp->batch, pcp);
+		free_pcppages_bulk(zone, pcp->batch, pcp, 0);
 		pcp->count -= pcp->batch;
 	}
 
@@ -1317,16 +1390,29 @@ struct page *buffered_rmqueue(struct zone *preferred_zone,
 	struct page *page;
 	int cold = !!(gfp_flags & __GFP_COLD);
 
+	if (unlikely(order && (gfp_flags & __GFP_NOFAIL))) {
+		/*
+		 * __GFP_NOFAIL is not to be used in new code.
+		 *
+		 * All __GFP_NOFAIL callers should be fixed so that they
+		 * properly detect and handle allocation failures.
+		 *
+		 * We most definitely don't want callers attempting to
+		 * allocate greater than order-1 page units with
+		 * __GFP_NOFAIL.
+		 */
+		WARN_ON_ONCE(order > 1);
+	}
 again:
-	if (likely(order == 0)) {
+	if (likely(order <= PCP_MAX_ORDER)) {
 		struct per_cpu_pages *pcp;
 		struct list_head *list;
 
 		local_irq_save(flags);
-		pcp = &this_cpu_ptr(zone->pageset)->pcp;
+		pcp = pcp_order(this_cpu_ptr(zone->pageset), order);
 		list = &pcp->lists[migratetype];
 		if (list_empty(list)) {
-			pcp->count += rmqueue_bulk(zone, 0,
+			pcp->count += rmqueue_bulk(zone, order,
 					pcp->batch, list,
 					migratetype, cold);
 			if (unlikely(list_empty(list)))
@@ -1341,21 +1427,10 @@ again:
 		list_del(&page->lru);
 		pcp->count--;
 	} else {
-		if (unlikely(gfp_flags & __GFP_NOFAIL)) {
-			/*
-			 * __GFP_NOFAIL is not to be used in new code.
-			 *
-			 * All __GFP_NOFAIL callers should be fixed so that they
-			 * properly detect and handle allocation failures.
-			 *
-			 * We most definitely don't want callers attempting to
-			 * allocate greater than order-1 page units with
-			 * __GFP_NOFAIL.
-			 */
-			WARN_ON_ONCE(order > 1);
-		}
 		spin_lock_irqsave(&zone->lock, flags);
+		zone_lock_acquired(zone);
 		page = __rmqueue(zone, order, migratetype);
+		zone_lock_releasing(zone);
 		spin_unlock(&zone->lock);
 		if (!page)
 			goto failed;
@@ -3654,10 +3729,28 @@ static int zone_batchsize(struct zone *zone)
 #endif
 }
 
+/*
+ * The high order lists hold blocks, not pages.  Their batch shrinks faster
+ * than the block size grows so the cache as a whole stays well below the
+ * order-0 one: with the default batch of 31 that is at most 56, 48 and 32
+ * pages for orders 1, 2 and 3.  No order-0 caching means none at all.
+ */
+static void setup_pcp_high(struct per_cpu_pageset *p)
+{
+	int order;
+
+	for (order = 1; order <= PCP_MAX_ORDER; order++) {
+		struct per_cpu_pages *pcp = pcp_order(p, order);
+
+		pcp->batch = max(1, p->pcp.batch >> (order + 1));
+		pcp->high = p->pcp.high ? 4 * pcp->batch : 0;
+	}
+}
+
 static void setup_pageset(struct per_cpu_pageset *p, unsigned long batch)
 {
 	struct per_cpu_pages *pcp;
-	int migratetype;
+	int migratetype, order;
 
 	memset(p, 0, sizeof(*p));
 
@@ -3665,8 +3758,13 @@ static void setup_pageset(struct per_cpu_pageset *p, unsigned long batch)
 	pcp->count = 0;
 	pcp->high = 6 * batch;
 	pcp->batch = max(1UL, 1 * batch);
-	for (migratetype = 0; migratetype < MIGRATE_PCPTYPES; migratetype++)
-		INIT_LIST_HEAD(&pcp->lists[migratetype]);
+	for (order = 0; order <= PCP_MAX_ORDER; order++) {
+		pcp = pcp_order(p, order);
+		for (migratetype = 0; migratetype < MIGRATE_PCPTYPES;
+		     migratetype++)
+			INIT_LIST_HEAD(&pcp->lists[migratetype]);
+	}
+	setup_pcp_high(p);
 }
 
 /*
@@ -3684,6 +3782,7 @@ static void setup_pagelist_highmark(struct per_cpu_pageset *p,
 	pcp->batch = max(1UL, high/4);
 	if ((high/4) > (PAGE_SHIFT * 8))
 		pcp->batch = PAGE_SHIFT * 8;
+	setup_pcp_high(p);
 }
 
 static void setup_zone_pageset(struct zone *zone)
@@ -3768,12 +3867,15 @@ static int __zone_pcp_update(void *data)
 	for_each_possible_cpu(cpu) {
 		struct per_cpu_pageset *pset;
 		struct per_cpu_pages *pcp;
+		int order;
 
 		pset = per_cpu_ptr(zone->pageset, cpu);
-		pcp = &pset->pcp;
 
 		local_irq_save(flags);
-		free_pcppages_bulk(zone, pcp->count, pcp);
+		for (order = 0; order <= PCP_MAX_ORDER; order++) {
+			pcp = pcp_order(pset, order);
+			free_pcppages_bulk(zone, pcp->count, pcp, order);
+		}
 		setup_pageset(pset, batch);
 		local_irq_restore(flags);
 	}
@@ -4381,6 +4483,13 @@ static void __paginginit free_area_init_core(struct pglist_data *pgdat,
 	pgdat_resize_init(pgdat);
 	pgdat->nr_zones = 0;
 	init_waitqueue_head(&pgdat->kswapd_wait);
+#ifdef CONFIG_COMPACTION
+	init_waitqueue_head(&pgdat->kcompactd_wait);
+#endif
+#ifdef CONFIG_PREZERO_PAGES
+	spin_lock_init(&pgdat->prezero_lock);
+	INIT_LIST_HEAD(&pgdat->prezero_list);
+#endif
 	pgdat->kswapd_max_order = 0;
 	pgdat_page_cgroup_init(pgdat);
 	
@@ -0,0 +1,241 @@
+/*
+ * Pre-zeroed pages for anonymous faults
+ *
+ * An anonymous write fault has to clear a fresh page before it can map
+ * it, and when a new application faults in its heap and stack that
+ * clearing is a good part of the time spent starting it.  The clearing
+ * does not have to happen in the fault: kprezerod zeroes pages while the
+ * CPUs have nothing better to do and keeps them on a pool per node, and
+ * do_anonymous_page() takes a page from the local pool before it falls
+ * back to allocating and clearing one itself.
+ *
+ * kprezerod runs as SCHED_IDLE, so it only ever gets a CPU that would
+ * otherwise idle.  It tops the pools up to vm.prezero_pages each, but
+ * only while a node has more than twice its high watermarks free, and
+ * without ever entering reclaim or waking kswapd.  A shrinker hands the
+ * pools back to the page allocator under memory pressure.
+ *
+ * The pools only hold local pages, so faults in tasks and vmas with a
+ * NUMA memory policy keep allocating the usual way.
+ */
+
+#include <linux/mm.h>
+#include <linux/mmzone.h>
+#include <linux/highmem.h>
+#include <linux/cpuset.h>
+#include <linux/kthread.h>
+#include <linux/freezer.h>
+#include <linux/sched.h>
+#include <linux/spinlock.h>
+#include <linux/sysctl.h>
+#include <linux/vmstat.h>
+#include <linux/prezero.h>
+
+#define PREZERO_GFP	((GFP_HIGHUSER_MOVABLE & ~__GFP_WAIT) | \
+			 __GFP_THISNODE | __GFP_NOWARN | __GFP_NO_KSWAPD)
+
+/* Target size of each node's pool, in pages */
+int sysctl_prezero_pages __read_mostly = 4 << (20 - PAGE_SHIFT);
+
+static DECLARE_WAIT_QUEUE_HEAD(prezero_wait);
+static bool prezero_kick = true;
+
+static void wake_prezerod(void)
+{
+	if (ACCESS_ONCE(prezero_kick))
+		return;
+	prezero_kick = true;
+	wake_up(&prezero_wait);
+}
+
+/*
+ * The pool is a luxury: only fill it from memory that is comfortably
+ * above what kswapd aims for.
+ */
+static bool prezero_can_fill(pg_data_t *pgdat)
+{
+	unsigned long free = 0, reserve = 0;
+	int i;
+
+	for (i = 0; i < pgdat->nr_zones; i++) {
+		struct zone *zone = pgdat->node_zones + i;
+
+		if (!populated_zone(zone))
+			continue;
+		free += zone_page_state(zone, NR_FREE_PAGES);
+		reserve += 2 * high_wmark_pages(zone);
+	}
+	return free > reserve;
+}
+
+static void prezero_fill_node(pg_data_t *pgdat)
+{
+	while (ACCESS_ONCE(pgdat->nr_prezero) < sysctl_prezero_pages &&
+	       prezero_can_fill(pgdat) && !kthread_should_stop()) {
+		struct page *page;
+
+		page = alloc_pages_exact_node(pgdat->node_id, PREZERO_GFP, 0);
+		if (!page)
+			break;
+		clear_highpage(page);
+		flush_dcache_page(page);
+
+		spin_lock(&pgdat->prezero_lock);
+		list_add(&page->lru, &pgdat->prezero_list);
+		pgdat->nr_prezero++;
+		spin_unlock(&pgdat->prezero_lock);
+
+		inc_zone_page_state(page, NR_PREZERO);
+		count_vm_event(PREZERO_FILL);
+		cond_resched();
+	}
+}
+
+/*
+ * Hand pages of @pgdat's pool back to the page allocator until at most
+ * @keep are left.  Returns the number of pages freed.
+ */
+static unsigned long prezero_trim_node(pg_data_t *pgdat, unsigned long keep)
+{
+	struct page *page, *next;
+	unsigned long freed = 0;
+	LIST_HEAD(pages);
+
+	spin_lock(&pgdat->prezero_lock);
+	while (pgdat->nr_prezero > keep) {
+		page = list_first_entry(&pgdat->prezero_list, struct page, lru);
+		list_move(&page->lru, &pages);
+		pgdat->nr_prezero--;
+		freed++;
+	}
+	spin_unlock(&pgdat->prezero_lock);
+
+	list_for_each_entry_safe(page, next, &pages, lru) {
+		dec_zone_page_state(page, NR_PREZERO);
+		__free_page(page);
+	}
+	return freed;
+}
+
+/**
+ * alloc_prezeroed_page - take a zeroed page for an anonymous fault
+ * @vma: the VMA the page is to be mapped into
+ *
+ * Returns a zeroed page from the local node's pool, or NULL if the pool
+ * is empty or cannot be used for @vma.  The caller then has to allocate
+ * and clear a page itself.
+ */
+struct page *alloc_prezeroed_page(struct vm_area_struct *vma)
+{
+	pg_data_t *pgdat = NODE_DATA(numa_node_id());
+	int target = ACCESS_ONCE(sysctl_prezero_pages);
+	struct page *page = NULL;
+	unsigned long nr = 0;
+
+	if (!target)
+		return NULL;
+#ifdef CONFIG_NUMA
+	if (vma->vm_policy || current->mempolicy ||
+	    !node_isset(pgdat->node_id, cpuset_current_mems_allowed))
+		return NULL;
+#endif
+
+	if (ACCESS_ONCE(pgdat->nr_prezero)) {
+		spin_lock(&pgdat->prezero_lock);
+		if (!list_empty(&pgdat->prezero_list)) {
+			page = list_first_entry(&pgdat->prezero_list,
+						struct page, lru);
+			list_del(&page->lru);
+			nr = --pgdat->nr_prezero;
+		}
+		spin_unlock(&pgdat->prezero_lock);
+	}
+
+	if (!page) {
+		count_vm_event(PREZERO_MISS);
+		if (prezero_can_fill(pgdat))
+			wake_prezerod();
+		return NULL;
+	}
+
+	dec_zone_page_state(page, NR_PREZERO);
+	count_vm_event(PREZERO_HIT);
+	if (nr < target / 2)
+		wake_prezerod();
+	return page;
+}
+
+static int kprezerod(void *unused)
+{
+	struct sched_param param = { .sched_priority = 0 };
+	int nid;
+
+	sched_setscheduler(current, SCHED_IDLE, &param);
+	set_freezable();
+
+	while (!kthread_should_stop()) {
+		wait_event_freezable(prezero_wait,
+				     prezero_kick || kthread_should_stop());
+		prezero_kick = false;
+
+		for_each_node_state(nid, N_HIGH_MEMORY)
+			prezero_fill_node(NODE_DATA(nid));
+	}
+	return 0;
+}
+
+static int prezero_shrink(struct shrinker *shrink, struct shrink_control *sc)
+{
+	unsigned long nr_to_scan = sc->nr_to_scan;
+	unsigned long nr = 0;
+	int nid;
+
+	for_each_node_state(nid, N_HIGH_MEMORY) {
+		pg_data_t *pgdat = NODE_DATA(nid);
+		unsigned long pool = ACCESS_ONCE(pgdat->nr_prezero);
+
+		if (nr_to_scan) {
+			unsigned long keep = pool > nr_to_scan ?
+					     pool - nr_to_scan : 0;
+
+			nr_to_scan -= prezero_trim_node(pgdat, keep);
+			pool = ACCESS_ONCE(pgdat->nr_prezero);
+		}
+		nr += pool;
+	}
+	return min_t(unsigned long, nr, INT_MAX);
+}
+
+static struct shrinker prezero_shrinker = {
+	.shrink = prezero_shrink,
+	.seeks = 1,
+};
+
+int prezero_sysctl_handler(struct ctl_table *table, int write,
+			   void __user *buffer, size_t *length, loff_t *ppos)
+{
+	int ret, nid;
+
+	ret = proc_dointvec_minmax(table, write, buffer, length, ppos);
+	if (ret || !write)
+		return ret;
+
+	for_each_node_state(nid, N_HIGH_MEMORY)
+		prezero_trim_node(NODE_DATA(nid), sysctl_prezero_pages);
+	wake_prezerod();
+	return 0;
+}
+
+static int __init prezero_init(void)
+{
+	struct task_struct *tsk;
+
+	tsk = kthread_run(kprezerod, NULL, "kprezerod");
+	if (IS_ERR(tsk)) {
+		printk(KERN_ERR "prezero: failed to start kprezerod\n");
+		return PTR_ERR(tsk);
+	}
+	register_shrinker(&prezero_shrinker);
+	return 0;
+}
+module_init(prezero_init)
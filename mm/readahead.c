@@ -19,6 +19,131 @@
 #include <linux/pagemap.h>
 #include <linux/swap.h>
 
+enum readahead_pattern {
+	RA_PATTERN_INITIAL,
+	RA_PATTERN_SUBSEQUENT,
+	RA_PATTERN_CONTEXT,
+	RA_PATTERN_STRIDE,
+	RA_PATTERN_OVERSIZE,
+	RA_PATTERN_RANDOM,
+	RA_PATTERN_MMAP,
+	RA_PATTERN_FORCED,
+	RA_PATTERN_MAX
+};
+
+#ifdef CONFIG_READAHEAD_STATS
+#include <linux/debugfs.h>
+#include <linux/seq_file.h>
+
+enum ra_account {
+	RA_ACCOUNT_COUNT,	/* readahead requests */
+	RA_ACCOUNT_ASYNC,	/* of which triggered by PG_readahead */
+	RA_ACCOUNT_IO,		/* of which had to read something */
+	RA_ACCOUNT_SIZE,	/* pages asked for */
+	RA_ACCOUNT_IO_SIZE,	/* of which were not cached yet */
+	RA_ACCOUNT_MAX
+};
+
+static const char * const ra_pattern_names[RA_PATTERN_MAX] = {
+	[RA_PATTERN_INITIAL]	= "initial",
+	[RA_PATTERN_SUBSEQUENT]	= "subsequent",
+	[RA_PATTERN_CONTEXT]	= "context",
+	[RA_PATTERN_STRIDE]	= "stride",
+	[RA_PATTERN_OVERSIZE]	= "oversize",
+	[RA_PATTERN_RANDOM]	= "random",
+	[RA_PATTERN_MMAP]	= "mmap",
+	[RA_PATTERN_FORCED]	= "forced",
+};
+
+static DEFINE_PER_CPU(unsigned long[RA_PATTERN_MAX][RA_ACCOUNT_MAX],
+		      ra_stats);
+
+static void readahead_event(enum readahead_pattern pattern, bool async,
+			    unsigned long size, int actual)
+{
+	preempt_disable();
+	__this_cpu_inc(ra_stats[pattern][RA_ACCOUNT_COUNT]);
+	if (async)
+		__this_cpu_inc(ra_stats[pattern][RA_ACCOUNT_ASYNC]);
+	if (actual > 0) {
+		__this_cpu_inc(ra_stats[pattern][RA_ACCOUNT_IO]);
+		__this_cpu_add(ra_stats[pattern][RA_ACCOUNT_IO_SIZE], actual);
+	}
+	__this_cpu_add(ra_stats[pattern][RA_ACCOUNT_SIZE], size);
+	preempt_enable();
+}
+
+static int readahead_stats_show(struct seq_file *m, void *v)
+{
+	unsigned long sum[RA_PATTERN_MAX][RA_ACCOUNT_MAX];
+	int cpu, i, j;
+
+	memset(sum, 0, sizeof(sum));
+	for_each_possible_cpu(cpu) {
+		unsigned long (*s)[RA_ACCOUNT_MAX] = per_cpu(ra_stats, cpu);
+
+		for (i = 0; i < RA_PATTERN_MAX; i++)
+			for (j = 0; j < RA_ACCOUNT_MAX; j++)
+				sum[i][j] += s[i][j];
+	}
+
+	seq_printf(m, "%-10s %10s %10s %10s %12s %12s\n",
+		   "pattern", "readahead", "async", "io",
+		   "size", "io_size");
+	for (i = 0; i < RA_PATTERN_MAX; i++)
+		seq_printf(m, "%-10s %10lu %10lu %10lu %12lu %12lu\n",
+			   ra_pattern_names[i],
+			   sum[i][RA_ACCOUNT_COUNT],
+			   sum[i][RA_ACCOUNT_ASYNC],
+			   sum[i][RA_ACCOUNT_IO],
+			   sum[i][RA_ACCOUNT_SIZE],
+			   sum[i][RA_ACCOUNT_IO_SIZE]);
+	return 0;
+}
+
+static int readahead_stats_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, readahead_stats_show, NULL);
+}
+
+static ssize_t readahead_stats_write(struct file *file,
+				     const char __user *buf,
+				     size_t size, loff_t *offset)
+{
+	int cpu;
+
+	for_each_possible_cpu(cpu)
+		memset(per_cpu(ra_stats, cpu), 0, sizeof(ra_stats));
+	return size;
+}
+
+static const struct file_operations readahead_stats_fops = {
+	.open		= readahead_stats_open,
+	.read		= seq_read,
+	.write		= readahead_stats_write,
+	.llseek		= seq_lseek,
+	.release	= single_release,
+};
+
+static int __init readahead_stats_init(void)
+{
+	struct dentry *root;
+
+	root = debugfs_create_dir("readahead", NULL);
+	if (!root)
+		return -ENOMEM;
+	debugfs_create_file("stats", 0644, root, NULL,
+			    &readahead_stats_fops);
+	return 0;
+}
+late_initcall(readahead_stats_init);
+#else
+static inline void readahead_event(enum readahead_pattern pattern,
+				   bool async, unsigned long size, int actual)
+{
+}
+#endif /* CONFIG_READAHEAD_STATS */
+
 /*
  * Initialise a struct file's readahead state.  Assumes that the caller has
  * memset *ra to zero.
@@ -248,6 +373,7 @@ int force_page_cache_readahead(struct address_space *mapping, struct file *filp,
 			this_chunk = nr_to_read;
 		err = __do_page_cache_readahead(mapping, filp,
 						offset, this_chunk, 0);
+		readahead_event(RA_PATTERN_FORCED, false, this_chunk, err);
 		if (err < 0) {
 			ret = err;
 			break;
@@ -269,6 +395,13 @@ unsigned long max_sane_readahead(unsigned long nr)
 		+ node_page_state(numa_node_id(), NR_FREE_PAGES)) / 2);
 }
 
+static int __ra_submit(struct file_ra_state *ra,
+		       struct address_space *mapping, struct file *filp)
+{
+	return __do_page_cache_readahead(mapping, filp,
+					 ra->start, ra->size, ra->async_size);
+}
+
 /*
  * Submit IO for the read-ahead request in file_ra_state.
  */
@@ -277,8 +410,8 @@ unsigned long ra_submit(struct file_ra_state *ra,
 {
 	int actual;
 
-	actual = __do_page_cache_readahead(mapping, filp,
-					ra->start, ra->size, ra->async_size);
+	actual = __ra_submit(ra, mapping, filp);
+	readahead_event(RA_PATTERN_MMAP, false, ra->size, actual);
 
 	return actual;
 }
@@ -358,7 +491,52 @@ static unsigned long get_next_ra_size(struct file_ra_state *ra,
  *
  * The code ramps up the readahead size aggressively at first, but slow down as
  * it approaches max_readhead.
+ *
+ * Reads that are neither sequential nor strided are counted in random_reads.
+ * Once a file has seen RA_RANDOM_THRESH of them it is treated as random: its
+ * misses are read as is, with no initial or context readahead around them,
+ * until sequential misses bring the count back down.  A miss at the same
+ * distance from the previous read as the last one is a strided read, and
+ * for short strides reading through the gaps is cheaper than seeking.
+ *
+ * Streams that keep consuming full windows on an uncongested device double
+ * their maximum window, up to RA_GROW_MAX times the device's read_ahead_kb.
+ * Read congestion on an asynchronous readahead halves it again.
  */
+#define RA_RANDOM_THRESH	4
+#define RA_RANDOM_MAX		16
+#define RA_GROW_MAX		4
+#define RA_GROW_LIMIT		((2 * 1024 * 1024) / PAGE_CACHE_SIZE)
+
+static inline bool ra_random(struct file_ra_state *ra)
+{
+	return ra->random_reads >= RA_RANDOM_THRESH;
+}
+
+static void ra_grow_window(struct address_space *mapping,
+			   struct file_ra_state *ra, unsigned long max)
+{
+	struct backing_dev_info *bdi = mapping->backing_dev_info;
+	unsigned long limit;
+
+	limit = min_t(unsigned long, bdi->ra_pages * RA_GROW_MAX,
+		      RA_GROW_LIMIT);
+	if (ra->size < max || ra->ra_pages >= limit)
+		return;
+	if (bdi_read_congested(bdi))
+		return;
+	ra->ra_pages = min_t(unsigned long, ra->ra_pages * 2, limit);
+}
+
+static void ra_shrink_window(struct address_space *mapping,
+			     struct file_ra_state *ra)
+{
+	unsigned long bdi_pages = mapping->backing_dev_info->ra_pages;
+
+	if (ra->ra_pages > bdi_pages)
+		ra->ra_pages = max_t(unsigned long, ra->ra_pages / 2,
+				     bdi_pages);
+}
 
 /*
  * Count contiguously cached pages from @offset-1 to @offset-@max,
@@ -423,12 +601,18 @@ ondemand_readahead(struct address_space *mapping,
 		   unsigned long req_size)
 {
 	unsigned long max = max_sane_readahead(ra->ra_pages);
+	enum readahead_pattern pattern = RA_PATTERN_INITIAL;
+	pgoff_t gap;
+	int actual;
 
 	/*
 	 * start of file
 	 */
-	if (!offset)
+	if (!offset) {
+		if (ra_random(ra))
+			goto read_as_is;
 		goto initial_readahead;
+	}
 
 	/*
 	 * It's the expected callback offset, assume sequential access.
@@ -436,9 +620,13 @@ ondemand_readahead(struct address_space *mapping,
 	 */
 	if ((offset == (ra->start + ra->size - ra->async_size) ||
 	     offset == (ra->start + ra->size))) {
+		ra_grow_window(mapping, ra, max);
+		max = max_sane_readahead(ra->ra_pages);
+		ra->random_reads = 0;
 		ra->start += ra->size;
 		ra->size = get_next_ra_size(ra, max);
 		ra->async_size = ra->size;
+		pattern = RA_PATTERN_SUBSEQUENT;
 		goto readit;
 	}
 
@@ -458,38 +646,68 @@ ondemand_readahead(struct address_space *mapping,
 		if (!start || start - offset > max)
 			return 0;
 
+		ra->random_reads = 0;
 		ra->start = start;
 		ra->size = start - offset;	/* old async_size */
 		ra->size += req_size;
 		ra->size = get_next_ra_size(ra, max);
 		ra->async_size = ra->size;
+		pattern = RA_PATTERN_SUBSEQUENT;
 		goto readit;
 	}
 
 	/*
 	 * oversize read
 	 */
-	if (req_size > max)
+	if (req_size > max) {
+		pattern = RA_PATTERN_OVERSIZE;
 		goto initial_readahead;
+	}
 
 	/*
 	 * sequential cache miss
 	 */
-	if (offset - (ra->prev_pos >> PAGE_CACHE_SHIFT) <= 1UL)
+	gap = offset - (ra->prev_pos >> PAGE_CACHE_SHIFT);
+	if (gap <= 1UL) {
+		ra->random_reads /= 2;
+		if (ra_random(ra))
+			goto read_as_is;
+		goto initial_readahead;
+	}
+
+	/*
+	 * strided cache miss
+	 * Read through the gaps rather than seek over them.
+	 */
+	if (gap == ra->stride && gap <= max / 4) {
+		pattern = RA_PATTERN_STRIDE;
+		req_size += gap;
 		goto initial_readahead;
+	}
+	ra->stride = gap <= max ? gap : 0;
 
 	/*
 	 * Query the page cache and look for the traces(cached history pages)
 	 * that a sequential stream would leave behind.
 	 */
-	if (try_context_readahead(mapping, ra, offset, req_size, max))
+	if (!ra_random(ra) &&
+	    try_context_readahead(mapping, ra, offset, req_size, max)) {
+		ra->random_reads = 0;
+		pattern = RA_PATTERN_CONTEXT;
 		goto readit;
+	}
 
 	/*
 	 * standalone, small random read
 	 * Read as is, and do not pollute the readahead state.
 	 */
-	return __do_page_cache_readahead(mapping, filp, offset, req_size, 0);
+	if (ra->random_reads < RA_RANDOM_MAX)
+		ra->random_reads++;
+read_as_is:
+	actual = __do_page_cache_readahead(mapping, filp, offset, req_size, 0);
+	readahead_event(RA_PATTERN_RANDOM, hit_readahead_marker,
+			req_size, actual);
+	return actual;
 
 initial_readahead:
 	ra->start = offset;
@@ -507,7 +725,9 @@ readit:
 		ra->size += ra->async_size;
 	}
 
-	return ra_submit(ra, mapping, filp);
+	actual = __ra_submit(ra, mapping, filp);
+	readahead_event(pattern, hit_readahead_marker, ra->size, actual);
+	return actual;
 }
 
 /**
@@ -577,10 +797,13 @@ page_cache_async_readahead(struct address_space *mapping,
 	ClearPageReadahead(page);
 
 	/*
-	 * Defer asynchronous read-ahead on IO congestion.
+	 * Defer asynchronous read-ahead on IO congestion, and take back
+	 * what the window grew beyond the device default.
 	 */
-	if (bdi_read_congested(mapping->backing_dev_info))
+	if (bdi_read_congested(mapping->backing_dev_info)) {
+		ra_shrink_window(mapping, ra);
 		return;
+	}
 
 	/* do read-ahead */
 	ondemand_readahead(mapping, ra, filp, true, offset, req_size);
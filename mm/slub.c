@@ -1441,10 +1441,23 @@ static __always_inline int slab_trylock(struct page *page)
 /*
  * Management of partially allocated slabs
  */
+static inline void lock_node_list(struct kmem_cache_node *n)
+{
+#ifdef CONFIG_SLUB_STATS
+	if (!spin_trylock(&n->list_lock)) {
+		spin_lock(&n->list_lock);
+		n->list_lock_contended++;
+	}
+	n->list_lock_acquired++;
+#else
+	spin_lock(&n->list_lock);
+#endif
+}
+
 static void add_partial(struct kmem_cache_node *n,
 				struct page *page, int tail)
 {
-	spin_lock(&n->list_lock);
+	lock_node_list(n);
 	n->nr_partial++;
 	if (tail)
 		list_add_tail(&page->lru, &n->partial);
@@ -1464,7 +1477,7 @@ static void remove_partial(struct kmem_cache *s, struct page *page)
 {
 	struct kmem_cache_node *n = get_node(s, page_to_nid(page));
 
-	spin_lock(&n->list_lock);
+	lock_node_list(n);
 	__remove_partial(n, page);
 	spin_unlock(&n->list_lock);
 }
@@ -1486,11 +1499,15 @@ static inline int lock_and_freeze_slab(struct kmem_cache_node *n,
 }
 
 /*
- * Try to allocate a partial slab from a specific node.
+ * Try to allocate a partial slab from a specific node.  While we hold the
+ * list_lock, also move up to half of cpu_partial more slabs over to the
+ * cpu partial list, so that the next few refills do not come back here.
  */
-static struct page *get_partial_node(struct kmem_cache_node *n)
+static struct page *get_partial_node(struct kmem_cache *s,
+		struct kmem_cache_node *n, struct kmem_cache_cpu *c)
 {
-	struct page *page;
+	struct page *page, *page2, *cpu_page = NULL;
+	unsigned int moved = 0;
 
 	/*
 	 * Racy check. If we mistakenly see no partial slabs then we
@@ -1501,20 +1518,37 @@ static struct page *get_partial_node(struct kmem_cache_node *n)
 	if (!n || !n->nr_partial)
 		return NULL;
 
-	spin_lock(&n->list_lock);
-	list_for_each_entry(page, &n->partial, lru)
-		if (lock_and_freeze_slab(n, page))
-			goto out;
-	page = NULL;
-out:
+	lock_node_list(n);
+	list_for_each_entry_safe(page, page2, &n->partial, lru) {
+		if (cpu_page && (moved >= s->cpu_partial / 2 ||
+				 c->nr_partial >= s->cpu_partial))
+			break;
+		if (!lock_and_freeze_slab(n, page))
+			continue;
+
+		if (!cpu_page) {
+			/* Returned with the slab lock held */
+			cpu_page = page;
+			if (!s->cpu_partial || kmem_cache_debug(s))
+				break;
+			continue;
+		}
+
+		slab_unlock(page);
+		list_add_tail(&page->lru, &c->partial);
+		c->nr_partial++;
+		moved++;
+		stat(s, CPU_PARTIAL_NODE);
+	}
 	spin_unlock(&n->list_lock);
-	return page;
+	return cpu_page;
 }
 
 /*
  * Get a page from somewhere. Search in increasing NUMA distances.
  */
-static struct page *get_any_partial(struct kmem_cache *s, gfp_t flags)
+static struct page *get_any_partial(struct kmem_cache *s, gfp_t flags,
+		struct kmem_cache_cpu *c)
 {
 #ifdef CONFIG_NUMA
 	struct zonelist *zonelist;
@@ -1556,7 +1590,7 @@ static struct page *get_any_partial(struct kmem_cache *s, gfp_t flags)
 
 			if (n && cpuset_zone_allowed_hardwall(zone, flags) &&
 					n->nr_partial > s->min_partial) {
-				page = get_partial_node(n);
+				page = get_partial_node(s, n, c);
 				if (page) {
 					/*
 					 * Return the object even if
@@ -1579,16 +1613,17 @@ static struct page *get_any_partial(struct kmem_cache *s, gfp_t flags)
 /*
  * Get a partial page, lock it and return it.
  */
-static struct page *get_partial(struct kmem_cache *s, gfp_t flags, int node)
+static struct page *get_partial(struct kmem_cache *s, gfp_t flags, int node,
+		struct kmem_cache_cpu *c)
 {
 	struct page *page;
 	int searchnode = (node == NUMA_NO_NODE) ? numa_node_id() : node;
 
-	page = get_partial_node(get_node(s, searchnode));
+	page = get_partial_node(s, get_node(s, searchnode), c);
 	if (page || node != NUMA_NO_NODE)
 		return page;
 
-	return get_any_partial(s, flags);
+	return get_any_partial(s, flags, c);
 }
 
 /*
@@ -1638,6 +1673,47 @@ static void unfreeze_slab(struct kmem_cache *s, struct page *page, int tail)
 	}
 }
 
+/*
+ * Give the cpu partial slabs back to their nodes, or to the page allocator
+ * if they emptied out meanwhile.
+ *
+ * Called with interrupts disabled.
+ */
+static void unfreeze_partials(struct kmem_cache *s, struct kmem_cache_cpu *c)
+{
+	struct page *page, *page2;
+
+	if (list_empty(&c->partial))
+		return;
+
+	stat(s, CPU_PARTIAL_DRAIN);
+	list_for_each_entry_safe(page, page2, &c->partial, lru) {
+		list_del(&page->lru);
+		slab_lock(page);
+		unfreeze_slab(s, page, 1);
+	}
+	c->nr_partial = 0;
+}
+
+/*
+ * Put a frozen slab on this cpu's partial list, where the allocation
+ * slowpath will find it without taking the list_lock.  If the list is
+ * full, its slabs go back to the node partial lists first.
+ *
+ * Called with interrupts disabled.
+ */
+static void put_cpu_partial(struct kmem_cache *s, struct page *page)
+{
+	struct kmem_cache_cpu *c = __this_cpu_ptr(s->cpu_slab);
+
+	if (c->nr_partial >= s->cpu_partial)
+		unfreeze_partials(s, c);
+
+	list_add(&page->lru, &c->partial);
+	c->nr_partial++;
+	stat(s, CPU_PARTIAL_FREE);
+}
+
 #ifdef CONFIG_PREEMPT
 /*
  * Calculate the next globally unique transaction for disambiguiation
@@ -1701,8 +1777,13 @@ void init_kmem_cache_cpus(struct kmem_cache *s)
 {
 	int cpu;
 
-	for_each_possible_cpu(cpu)
-		per_cpu_ptr(s->cpu_slab, cpu)->tid = init_tid(cpu);
+	for_each_possible_cpu(cpu) {
+		struct kmem_cache_cpu *c = per_cpu_ptr(s->cpu_slab, cpu);
+
+		c->tid = init_tid(cpu);
+		INIT_LIST_HEAD(&c->partial);
+		c->nr_partial = 0;
+	}
 }
 /*
  * Remove the cpu slab
@@ -1755,8 +1836,11 @@ static inline void __flush_cpu_slab(struct kmem_cache *s, int cpu)
 {
 	struct kmem_cache_cpu *c = per_cpu_ptr(s->cpu_slab, cpu);
 
-	if (likely(c && c->page))
-		flush_slab(s, c);
+	if (likely(c)) {
+		if (c->page)
+			flush_slab(s, c);
+		unfreeze_partials(s, c);
+	}
 }
 
 static void flush_cpu_slab(void *d)
@@ -1922,7 +2006,20 @@ another_slab:
 	deactivate_slab(s, c);
 
 new_slab:
-	page = get_partial(s, gfpflags, node);
+	if (!list_empty(&c->partial)) {
+		page = list_first_entry(&c->partial, struct page, lru);
+		if (node == NUMA_NO_NODE || page_to_nid(page) == node) {
+			list_del(&page->lru);
+			c->nr_partial--;
+			stat(s, CPU_PARTIAL_ALLOC);
+			slab_lock(page);
+			c->node = page_to_nid(page);
+			c->page = page;
+			goto load_freelist;
+		}
+	}
+
+	page = get_partial(s, gfpflags, node, c);
 	if (page) {
 		stat(s, ALLOC_FROM_PARTIAL);
 		c->node = page_to_nid(page);
@@ -2136,9 +2233,16 @@ static void __slab_free(struct kmem_cache *s, struct page *page,
 
 	/*
 	 * Objects left in the slab. If it was not on the partial list before
-	 * then add it.
+	 * then add it, to this cpu's partial list if it keeps one.
 	 */
 	if (unlikely(!prior)) {
+		if (s->cpu_partial && !kmem_cache_debug(s)) {
+			__SetPageSlubFrozen(page);
+			slab_unlock(page);
+			put_cpu_partial(s, page);
+			local_irq_restore(flags);
+			return;
+		}
 		add_partial(get_node(s, page_to_nid(page)), page, 1);
 		stat(s, FREE_ADD_PARTIAL);
 	}
@@ -2394,6 +2498,10 @@ init_kmem_cache_node(struct kmem_cache_node *n, struct kmem_cache *s)
 	atomic_long_set(&n->total_objects, 0);
 	INIT_LIST_HEAD(&n->full);
 #endif
+#ifdef CONFIG_SLUB_STATS
+	n->list_lock_acquired = 0;
+	n->list_lock_contended = 0;
+#endif
 }
 
 static inline int alloc_kmem_cache_cpus(struct kmem_cache *s)
@@ -2675,6 +2783,22 @@ static int kmem_cache_open(struct kmem_cache *s,
 	 * list to avoid pounding the page allocator excessively.
 	 */
 	set_min_partial(s, ilog2(s->size));
+
+	/*
+	 * cpu_partial is the number of partial slabs kept per cpu.  Slabs
+	 * of large objects are larger, so keep fewer of them around.
+	 * Debugging needs every slab on the node lists.
+	 */
+	if (kmem_cache_debug(s))
+		s->cpu_partial = 0;
+	else if (s->size >= PAGE_SIZE)
+		s->cpu_partial = 2;
+	else if (s->size >= 1024)
+		s->cpu_partial = 4;
+	else if (s->size >= 256)
+		s->cpu_partial = 8;
+	else
+		s->cpu_partial = 13;
 	s->refcount = 1;
 #ifdef CONFIG_NUMA
 	s->remote_node_defrag_ratio = 1000;
@@ -4222,6 +4346,29 @@ static ssize_t min_partial_store(struct kmem_cache *s, const char *buf,
 }
 SLAB_ATTR(min_partial);
 
+static ssize_t cpu_partial_show(struct kmem_cache *s, char *buf)
+{
+	return sprintf(buf, "%u\n", s->cpu_partial);
+}
+
+static ssize_t cpu_partial_store(struct kmem_cache *s, const char *buf,
+				 size_t length)
+{
+	unsigned long nr;
+	int err;
+
+	err = strict_strtoul(buf, 10, &nr);
+	if (err)
+		return err;
+	if (nr && kmem_cache_debug(s))
+		return -EINVAL;
+
+	s->cpu_partial = nr;
+	flush_all(s);
+	return length;
+}
+SLAB_ATTR(cpu_partial);
+
 static ssize_t ctor_show(struct kmem_cache *s, char *buf)
 {
 	if (!s->ctor)
@@ -4260,6 +4407,29 @@ static ssize_t objects_partial_show(struct kmem_cache *s, char *buf)
 }
 SLAB_ATTR_RO(objects_partial);
 
+static ssize_t slabs_cpu_partial_show(struct kmem_cache *s, char *buf)
+{
+	unsigned long sum = 0;
+	int cpu;
+	int len;
+
+	for_each_online_cpu(cpu)
+		sum += per_cpu_ptr(s->cpu_slab, cpu)->nr_partial;
+
+	len = sprintf(buf, "%lu", sum);
+
+#ifdef CONFIG_SMP
+	for_each_online_cpu(cpu) {
+		int nr = per_cpu_ptr(s->cpu_slab, cpu)->nr_partial;
+
+		if (nr && len < PAGE_SIZE - 20)
+			len += sprintf(buf + len, " C%d=%d", cpu, nr);
+	}
+#endif
+	return len + sprintf(buf + len, "\n");
+}
+SLAB_ATTR_RO(slabs_cpu_partial);
+
 static ssize_t reclaim_account_show(struct kmem_cache *s, char *buf)
 {
 	return sprintf(buf, "%d\n", !!(s->flags & SLAB_RECLAIM_ACCOUNT));
@@ -4568,6 +4738,72 @@ STAT_ATTR(DEACTIVATE_TO_HEAD, deactivate_to_head);
 STAT_ATTR(DEACTIVATE_TO_TAIL, deactivate_to_tail);
 STAT_ATTR(DEACTIVATE_REMOTE_FREES, deactivate_remote_frees);
 STAT_ATTR(ORDER_FALLBACK, order_fallback);
+STAT_ATTR(CMPXCHG_DOUBLE_CPU_FAIL, cmpxchg_double_cpu_fail);
+STAT_ATTR(CPU_PARTIAL_ALLOC, cpu_partial_alloc);
+STAT_ATTR(CPU_PARTIAL_FREE, cpu_partial_free);
+STAT_ATTR(CPU_PARTIAL_NODE, cpu_partial_node);
+STAT_ATTR(CPU_PARTIAL_DRAIN, cpu_partial_drain);
+
+static int show_list_lock(struct kmem_cache *s, char *buf, int contended)
+{
+	unsigned long sum = 0;
+	int node;
+	int len;
+
+	for_each_node_state(node, N_NORMAL_MEMORY) {
+		struct kmem_cache_node *n = get_node(s, node);
+
+		sum += contended ? n->list_lock_contended :
+				   n->list_lock_acquired;
+	}
+
+	len = sprintf(buf, "%lu", sum);
+
+#ifdef CONFIG_NUMA
+	for_each_node_state(node, N_NORMAL_MEMORY) {
+		struct kmem_cache_node *n = get_node(s, node);
+		unsigned long x = contended ? n->list_lock_contended :
+					      n->list_lock_acquired;
+
+		if (x && len < PAGE_SIZE - 30)
+			len += sprintf(buf + len, " N%d=%lu", node, x);
+	}
+#endif
+	return len + sprintf(buf + len, "\n");
+}
+
+static void clear_list_lock(struct kmem_cache *s)
+{
+	int node;
+
+	for_each_node_state(node, N_NORMAL_MEMORY) {
+		struct kmem_cache_node *n = get_node(s, node);
+
+		n->list_lock_acquired = 0;
+		n->list_lock_contended = 0;
+	}
+}
+
+static ssize_t list_lock_acquired_show(struct kmem_cache *s, char *buf)
+{
+	return show_list_lock(s, buf, 0);
+}
+
+static ssize_t list_lock_acquired_store(struct kmem_cache *s,
+				const char *buf, size_t length)
+{
+	if (buf[0] != '0')
+		return -EINVAL;
+	clear_list_lock(s);
+	return length;
+}
+SLAB_ATTR(list_lock_acquired);
+
+static ssize_t list_lock_contended_show(struct kmem_cache *s, char *buf)
+{
+	return show_list_lock(s, buf, 1);
+}
+SLAB_ATTR_RO(list_lock_contended);
 #endif
 
 static struct attribute *slab_attrs[] = {
@@ -4576,10 +4812,12 @@ static struct attribute *slab_attrs[] = {
 	&objs_per_slab_attr.attr,
 	&order_attr.attr,
 	&min_partial_attr.attr,
+	&cpu_partial_attr.attr,
 	&objects_attr.attr,
 	&objects_partial_attr.attr,
 	&partial_attr.attr,
 	&cpu_slabs_attr.attr,
+	&slabs_cpu_partial_attr.attr,
 	&ctor_attr.attr,
 	&aliases_attr.attr,
 	&align_attr.attr,
@@ -4625,6 +4863,13 @@ static struct attribute *slab_attrs[] = {
 	&deactivate_to_tail_attr.attr,
 	&deactivate_remote_frees_attr.attr,
 	&order_fallback_attr.attr,
+	&cmpxchg_double_cpu_fail_attr.attr,
+	&cpu_partial_alloc_attr.attr,
+	&cpu_partial_free_attr.attr,
+	&cpu_partial_node_attr.attr,
+	&cpu_partial_drain_attr.attr,
+	&list_lock_acquired_attr.attr,
+	&list_lock_contended_attr.attr,
 #endif
 #ifdef CONFIG_FAILSLAB
 	&failslab_attr.attr,
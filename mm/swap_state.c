@@ -127,6 +127,10 @@ void __delete_from_swap_cache(struct page *page)
 	VM_BUG_ON(!PageSwapCache(page));
 	VM_BUG_ON(PageWriteback(page));
 
+	/* Read ahead but never looked up */
+	if (TestClearPageReadahead(page))
+		count_vm_event(SWAP_RA_MISS);
+
 	radix_tree_delete(&swapper_space.page_tree, page_private(page));
 	set_page_private(page, 0);
 	ClearPageSwapCache(page);
@@ -266,8 +270,13 @@ struct page * lookup_swap_cache(swp_entry_t entry)
 
 	page = find_get_page(&swapper_space, entry.val);
 
-	if (page)
+	if (page) {
 		INC_CACHE_INFO(find_success);
+		if (TestClearPageReadahead(page)) {
+			count_vm_event(SWAP_RA_HIT);
+			swap_ra_hit(entry);
+		}
+	}
 
 	INC_CACHE_INFO(find_total);
 	return page;
@@ -279,12 +288,14 @@ struct page * lookup_swap_cache(swp_entry_t entry)
  * A failure return means that either the page allocation failed or that
  * the swap entry is no longer in use.
  */
-struct page *read_swap_cache_async(swp_entry_t entry, gfp_t gfp_mask,
-			struct vm_area_struct *vma, unsigned long addr)
+static struct page *__read_swap_cache_async(swp_entry_t entry,
+			gfp_t gfp_mask, struct vm_area_struct *vma,
+			unsigned long addr, bool *new_page_allocated)
 {
 	struct page *found_page, *new_page = NULL;
 	int err;
 
+	*new_page_allocated = false;
 	do {
 		/*
 		 * First check the swap cache.  Since this is normally
@@ -351,6 +362,7 @@ struct page *read_swap_cache_async(swp_entry_t entry, gfp_t gfp_mask,
 			 */
 			lru_cache_add_anon(new_page);
 			swap_readpage(new_page);
+			*new_page_allocated = true;
 			return new_page;
 		}
 		radix_tree_preload_end();
@@ -368,6 +380,37 @@ struct page *read_swap_cache_async(swp_entry_t entry, gfp_t gfp_mask,
 	return found_page;
 }
 
+struct page *read_swap_cache_async(swp_entry_t entry, gfp_t gfp_mask,
+			struct vm_area_struct *vma, unsigned long addr)
+{
+	bool page_allocated;
+
+	return __read_swap_cache_async(entry, gfp_mask, vma, addr,
+				       &page_allocated);
+}
+
+/*
+ * Pages brought in by readahead, as opposed to the one faulted on, are
+ * tagged PG_readahead so that lookup_swap_cache() can tell whether the
+ * readahead was any use, see swapin_nr_pages().
+ */
+static void swap_ra_page(swp_entry_t entry, gfp_t gfp_mask,
+			 struct vm_area_struct *vma, unsigned long addr)
+{
+	struct page *page;
+	bool page_allocated;
+
+	page = __read_swap_cache_async(entry, gfp_mask, vma, addr,
+				       &page_allocated);
+	if (!page)
+		return;
+	if (page_allocated) {
+		SetPageReadahead(page);
+		count_vm_event(SWAP_RA);
+	}
+	page_cache_release(page);
+}
+
 /**
  * swapin_readahead - swap in pages in hope we need them soon
  * @entry: swap entry of this memory
@@ -378,7 +421,8 @@ struct page *read_swap_cache_async(swp_entry_t entry, gfp_t gfp_mask,
  * Returns the struct page for entry and addr, after queueing swapin.
  *
  * Primitive swap readahead code. We simply read an aligned block of
- * (1 << page_cluster) entries in the swap area. This method is chosen
+ * up to (1 << page_cluster) entries in the swap area, sized by how much
+ * of the previous readahead was used. This method is chosen
  * because it doesn't cost us any seek time.  We also make sure to queue
  * the 'original' request together with the readahead ones...
  *
@@ -391,7 +435,6 @@ struct page *swapin_readahead(swp_entry_t entry, gfp_t gfp_mask,
 			struct vm_area_struct *vma, unsigned long addr)
 {
 	int nr_pages;
-	struct page *page;
 	unsigned long offset;
 	unsigned long end_offset;
 
@@ -405,12 +448,84 @@ struct page *swapin_readahead(swp_entry_t entry, gfp_t gfp_mask,
 	nr_pages = valid_swaphandles(entry, &offset);
 	for (end_offset = offset + nr_pages; offset < end_offset; offset++) {
 		/* Ok, do the async read-ahead now */
-		page = read_swap_cache_async(swp_entry(swp_type(entry), offset),
-						gfp_mask, vma, addr);
-		if (!page)
-			break;
-		page_cache_release(page);
+		if (offset == swp_offset(entry))
+			continue;
+		swap_ra_page(swp_entry(swp_type(entry), offset),
+			     gfp_mask, vma, addr);
 	}
 	lru_add_drain();	/* Push any new pages onto the LRU now */
 	return read_swap_cache_async(entry, gfp_mask, vma, addr);
 }
+
+#define SWAP_RA_VMA_MAX		16
+
+/**
+ * swap_vma_readahead - swap in pages mapped around the faulting address
+ * @fentry: swap entry of the faulting pte
+ * @gfp_mask: memory allocation flags
+ * @vma: user vma the faulting address belongs to
+ * @addr: faulting address
+ * @pmd: pmd covering @addr
+ *
+ * Returns the struct page for @fentry, after queueing swapin.
+ *
+ * On devices where readahead around the swap slot is not worth it, see
+ * swap_ra_vma_based(), read the swapped out neighbours of @addr in the
+ * page table instead, within @vma and the pmd.  They are what the task
+ * is most likely to touch next, wherever they ended up in swap.  Other
+ * devices get swapin_readahead().
+ *
+ * Caller must hold down_read on the vma->vm_mm, and not the pte lock.
+ */
+struct page *swap_vma_readahead(swp_entry_t fentry, gfp_t gfp_mask,
+			struct vm_area_struct *vma, unsigned long addr,
+			pmd_t *pmd)
+{
+	swp_entry_t entries[SWAP_RA_VMA_MAX];
+	unsigned long addrs[SWAP_RA_VMA_MAX];
+	unsigned long start, end, ra;
+	unsigned int win;
+	pte_t *orig_pte, *pte;
+	int i, nr = 0;
+
+	if (!swap_ra_vma_based(fentry))
+		return swapin_readahead(fentry, gfp_mask, vma, addr);
+
+	win = swapin_nr_pages(fentry, addr >> PAGE_SHIFT);
+	win = min_t(unsigned int, win, SWAP_RA_VMA_MAX);
+	if (win <= 1)
+		goto skip;
+
+	start = addr & ~((win << PAGE_SHIFT) - 1);
+	end = start + (win << PAGE_SHIFT);
+	start = max3(start, vma->vm_start, addr & PMD_MASK);
+	end = min(end, pmd_addr_end(addr, vma->vm_end));
+
+	/*
+	 * No pte lock: the entries are only hints, read_swap_cache_async()
+	 * checks that they are still in use.
+	 */
+	orig_pte = pte = pte_offset_map(pmd, start);
+	for (ra = start; ra < end; ra += PAGE_SIZE, pte++) {
+		pte_t ptent = *pte;
+		swp_entry_t entry;
+
+		if (ra == (addr & PAGE_MASK))
+			continue;
+		if (pte_none(ptent) || pte_present(ptent) || pte_file(ptent))
+			continue;
+		entry = pte_to_swp_entry(ptent);
+		if (non_swap_entry(entry) ||
+		    swp_type(entry) != swp_type(fentry))
+			continue;
+		entries[nr] = entry;
+		addrs[nr++] = ra;
+	}
+	pte_unmap(orig_pte);
+
+	for (i = 0; i < nr; i++)
+		swap_ra_page(entries[i], gfp_mask, vma, addrs[i]);
+	lru_add_drain();
+skip:
+	return read_swap_cache_async(fentry, gfp_mask, vma, addr);
+}
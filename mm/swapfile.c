@@ -2340,6 +2340,68 @@ int swapcache_prepare(swp_entry_t entry)
 	return __swap_duplicate(entry, SWAP_HAS_CACHE);
 }
 
+/*
+ * Size the next swapin readahead window of the device @entry lives on.
+ * @cursor is where the fault is: the swap offset for readahead around
+ * the slot, the virtual page number for readahead around the address.
+ *
+ * The window grows with the number of read ahead pages that were used
+ * since the previous fault, up to 1 << page_cluster, and shrinks by half
+ * at a time when they were not.  With no hits at all it only stays open
+ * for faults next to the previous one, so random access on a device where
+ * readahead does not pay quickly ends up reading single pages.
+ */
+unsigned int swapin_nr_pages(swp_entry_t entry, unsigned long cursor)
+{
+	struct swap_info_struct *si = swap_info[swp_type(entry)];
+	unsigned int max_pages, pages, hits, last;
+	unsigned long prev;
+
+	max_pages = 1 << ACCESS_ONCE(page_cluster);
+	if (max_pages <= 1)
+		return 1;
+
+	hits = atomic_xchg(&si->ra_hits, 0);
+	prev = si->ra_prev;
+	si->ra_prev = cursor;
+
+	pages = hits + 2;
+	if (pages == 2) {
+		if (cursor != prev + 1 && cursor != prev - 1)
+			pages = 1;
+	} else {
+		pages = roundup_pow_of_two(pages);
+	}
+	if (pages > max_pages)
+		pages = max_pages;
+
+	/* Don't shrink the window too fast */
+	last = si->ra_win / 2;
+	if (pages < last)
+		pages = last;
+	si->ra_win = pages;
+
+	return pages;
+}
+
+/*
+ * Readahead around the faulting slot makes sense where that slot's
+ * neighbours are cheap to read along with it, i.e. on rotating disks.
+ * On in-memory and other non-rotational devices every extra page costs
+ * as much as a separate read (a decompression for zram), so only pages
+ * that are likely to be used, the ones mapped next to the faulting
+ * address, are read ahead.
+ */
+bool swap_ra_vma_based(swp_entry_t entry)
+{
+	return swap_info[swp_type(entry)]->flags & SWP_SOLIDSTATE;
+}
+
+void swap_ra_hit(swp_entry_t entry)
+{
+	atomic_inc(&swap_info[swp_type(entry)]->ra_hits);
+}
+
 /*
  * swap_lock prevents swap_map being freed. Don't grab an extra
  * reference on the swaphandle, it doesn't matter if it becomes unused.
@@ -2347,11 +2409,12 @@ int swapcache_prepare(swp_entry_t entry)
 int valid_swaphandles(swp_entry_t entry, unsigned long *offset)
 {
 	struct swap_info_struct *si;
-	int our_page_cluster = page_cluster;
+	int our_page_cluster;
 	pgoff_t target, toff;
 	pgoff_t base, end;
 	int nr_pages = 0;
 
+	our_page_cluster = ilog2(swapin_nr_pages(entry, swp_offset(entry)));
 	if (!our_page_cluster)	/* no readahead */
 		return 0;
 
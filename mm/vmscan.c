@@ -114,6 +114,9 @@ struct scan_control {
 	 * are scanned.
 	 */
 	nodemask_t	*nodemask;
+
+	/* Reclaim pages even if they were referenced recently */
+	int ignore_references;
 };
 
 #define lru_to_page(_head) (list_entry((_head)->prev, struct page, lru))
@@ -578,6 +581,8 @@ static int __remove_mapping(struct address_space *mapping, struct page *page)
 
 		__delete_from_page_cache(page);
 		spin_unlock_irq(&mapping->tree_lock);
+		if (page_is_file_cache(page))
+			workingset_eviction(mapping, page);
 		mem_cgroup_uncharge_cache_page(page);
 
 		if (freepage != NULL)
@@ -704,6 +709,10 @@ static enum page_references page_check_references(struct page *page,
 	if (sc->reclaim_mode & RECLAIM_MODE_LUMPYRECLAIM)
 		return PAGEREF_RECLAIM;
 
+	/* Userspace asked for these pages to go, see reclaim_pages_from_list */
+	if (sc->ignore_references)
+		return PAGEREF_RECLAIM;
+
 	/*
 	 * Mlock lost the isolation race with us.  Let try_to_unmap()
 	 * move the page to the unevictable list.
@@ -802,7 +811,7 @@ static unsigned long shrink_page_list(struct list_head *page_list,
 			goto keep;
 
 		VM_BUG_ON(PageActive(page));
-		VM_BUG_ON(page_zone(page) != zone);
+		VM_BUG_ON(zone && page_zone(page) != zone);
 
 		sc->nr_scanned++;
 
@@ -866,7 +875,12 @@ static unsigned long shrink_page_list(struct list_head *page_list,
 		 * processes. Try to unmap it here.
 		 */
 		if (page_mapped(page) && mapping) {
-			switch (try_to_unmap(page, TTU_UNMAP)) {
+			enum ttu_flags ttu = TTU_UNMAP;
+
+			if (sc->ignore_references)
+				ttu |= TTU_IGNORE_ACCESS;
+
+			switch (try_to_unmap(page, ttu)) {
 			case SWAP_FAIL:
 				goto activate_locked;
 			case SWAP_AGAIN:
@@ -1027,7 +1041,8 @@ keep_lumpy:
 	 * back off and wait for congestion to clear because further reclaim
 	 * will encounter the same problem
 	 */
-	if (nr_dirty && nr_dirty == nr_congested && scanning_global_lru(sc))
+	if (zone && nr_dirty && nr_dirty == nr_congested &&
+	    scanning_global_lru(sc))
 		zone_set_flag(zone, ZONE_CONGESTED);
 
 	free_page_list(&free_pages);
@@ -1039,6 +1054,67 @@ keep_lumpy:
 	return nr_reclaimed;
 }
 
+#ifdef CONFIG_PROCESS_RECLAIM
+/*
+ * Reclaim the pages on @page_list, which the caller isolated from the LRU
+ * with isolate_lru_page() and counted in NR_ISOLATED_ANON/NR_ISOLATED_FILE,
+ * and which may come from any zone, regardless of how recently they were
+ * referenced.  Anonymous pages are swapped out.  Whatever cannot be freed
+ * goes back on the LRU.  Used by /proc/<pid>/reclaim; returns the number
+ * of pages freed.
+ */
+unsigned long reclaim_pages_from_list(struct list_head *page_list)
+{
+	struct scan_control sc = {
+		.gfp_mask = GFP_KERNEL,
+		.may_writepage = 1,
+		.may_unmap = 1,
+		.may_swap = 1,
+		.swappiness = vm_swappiness,
+		.ignore_references = 1,
+	};
+	unsigned long nr_reclaimed = 0, nr_dirty = 0, nr_writeback = 0;
+	struct page *page, *next;
+
+	list_for_each_entry(page, page_list, lru)
+		ClearPageActive(page);
+
+	/*
+	 * Freed pages cannot be told apart afterwards, so reclaim a batch
+	 * per zone and LRU type to know which isolation count to drop.
+	 */
+	while (!list_empty(page_list)) {
+		LIST_HEAD(batch);
+		struct zone *zone;
+		int file, nr = 0;
+
+		page = lru_to_page(page_list);
+		zone = page_zone(page);
+		file = page_is_file_cache(page);
+		list_for_each_entry_safe(page, next, page_list, lru) {
+			if (page_zone(page) != zone ||
+			    page_is_file_cache(page) != file)
+				continue;
+			list_move(&page->lru, &batch);
+			nr++;
+		}
+
+		nr_reclaimed += shrink_page_list(&batch, NULL, &sc,
+						 DEF_PRIORITY, &nr_dirty,
+						 &nr_writeback);
+
+		while (!list_empty(&batch)) {
+			page = lru_to_page(&batch);
+			list_del(&page->lru);
+			putback_lru_page(page);
+		}
+		mod_zone_page_state(zone, NR_ISOLATED_ANON + file, -nr);
+	}
+
+	return nr_reclaimed;
+}
+#endif
+
 /*
  * Attempt to remove the specified page from its LRU.  Only take this page
  * if it is of the appropriate PageActive status.  Pages which are being
@@ -2910,7 +2986,14 @@ out:
 	return order;
 }
 
-static void kswapd_try_to_sleep(pg_data_t *pgdat, int order, int classzone_idx)
+/*
+ * @reclaim_order is the order balance_pgdat() managed to balance the node
+ * for, @alloc_order the order kswapd was woken for.  The two differ when
+ * high-order reclaim gave up because of fragmentation, which is exactly
+ * when kcompactd should take over.
+ */
+static void kswapd_try_to_sleep(pg_data_t *pgdat, int alloc_order,
+				int reclaim_order, int classzone_idx)
 {
 	long remaining = 0;
 	DEFINE_WAIT(wait);
@@ -2921,7 +3004,8 @@ static void kswapd_try_to_sleep(pg_data_t *pgdat, int order, int classzone_idx)
 	prepare_to_wait(&pgdat->kswapd_wait, &wait, TASK_INTERRUPTIBLE);
 
 	/* Try to sleep for a short interval */
-	if (!sleeping_prematurely(pgdat, order, remaining, classzone_idx)) {
+	if (!sleeping_prematurely(pgdat, reclaim_order, remaining,
+				  classzone_idx)) {
 		remaining = schedule_timeout(HZ/10);
 		finish_wait(&pgdat->kswapd_wait, &wait);
 		prepare_to_wait(&pgdat->kswapd_wait, &wait, TASK_INTERRUPTIBLE);
@@ -2931,9 +3015,17 @@ static void kswapd_try_to_sleep(pg_data_t *pgdat, int order, int classzone_idx)
 	 * After a short sleep, check if it was a premature sleep. If not, then
 	 * go fully to sleep until explicitly woken up.
 	 */
-	if (!sleeping_prematurely(pgdat, order, remaining, classzone_idx)) {
+	if (!sleeping_prematurely(pgdat, reclaim_order, remaining,
+				  classzone_idx)) {
 		trace_mm_vmscan_kswapd_sleep(pgdat->node_id);
 
+		/*
+		 * The free pages are there now, have kcompactd turn them
+		 * into the high-order block kswapd was woken for before
+		 * somebody has to compact directly.
+		 */
+		wakeup_kcompactd(pgdat, alloc_order, classzone_idx);
+
 		/*
 		 * vmstat counters are not perfectly accurate and the estimated
 		 * value for counters such as NR_FREE_PAGES can deviate from the
@@ -3038,7 +3130,7 @@ static int kswapd(void *p)
 			order = new_order;
 			classzone_idx = new_classzone_idx;
 		} else {
-			kswapd_try_to_sleep(pgdat, balanced_order,
+			kswapd_try_to_sleep(pgdat, order, balanced_order,
 						balanced_classzone_idx);
 			order = pgdat->kswapd_max_order;
 			classzone_idx = pgdat->classzone_idx;
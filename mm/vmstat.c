@@ -709,6 +709,9 @@ const char * const vmstat_text[] = {
 	"nr_shmem",
 	"nr_dirtied",
 	"nr_written",
+	"workingset_refault",
+	"workingset_activate",
+	"nr_prezero",
 
 #ifdef CONFIG_NUMA
 	"numa_hit",
@@ -756,6 +759,9 @@ const char * const vmstat_text[] = {
 	"allocstall",
 
 	"pgrotated",
+	"swap_ra",
+	"swap_ra_hit",
+	"swap_ra_miss",
 
 #ifdef CONFIG_COMPACTION
 	"compact_blocks_moved",
@@ -786,6 +792,17 @@ const char * const vmstat_text[] = {
 	"thp_collapse_alloc_failed",
 	"thp_split",
 #endif
+#ifdef CONFIG_ANON_LARGE_PAGES
+	"anon_large_alloc",
+	"anon_large_fallback",
+	"anon_large_fold",
+	"anon_large_split",
+#endif
+#ifdef CONFIG_PREZERO_PAGES
+	"prezero_fill",
+	"prezero_hit",
+	"prezero_miss",
+#endif
 
 #endif /* CONFIG_VM_EVENTS_COUNTERS */
 };
@@ -967,7 +984,7 @@ static const struct file_operations pagetypeinfo_file_ops = {
 static void zoneinfo_show_print(struct seq_file *m, pg_data_t *pgdat,
 							struct zone *zone)
 {
-	int i;
+	int i, order;
 	seq_printf(m, "Node %d, zone %8s", pgdat->node_id, zone->name);
 	seq_printf(m,
 		   "\n  pages free     %lu"
@@ -1010,6 +1027,15 @@ static void zoneinfo_show_print(struct seq_file *m, pg_data_t *pgdat,
 			   pageset->pcp.count,
 			   pageset->pcp.high,
 			   pageset->pcp.batch);
+		for (order = 1; order <= PCP_MAX_ORDER; order++) {
+			struct per_cpu_pages *pcp;
+
+			pcp = &pageset->pcp_high[order - 1];
+			seq_printf(m,
+				   "\n      order %i: count: %i high: %i"
+				   " batch: %i",
+				   order, pcp->count, pcp->high, pcp->batch);
+		}
 #ifdef CONFIG_SMP
 		seq_printf(m, "\n  vm stats threshold: %d",
 				pageset->stat_threshold);
@@ -1022,6 +1048,21 @@ static void zoneinfo_show_print(struct seq_file *m, pg_data_t *pgdat,
 		   zone->all_unreclaimable,
 		   zone->zone_start_pfn,
 		   zone->inactive_ratio);
+#ifdef CONFIG_ZONE_LOCK_STATS
+	/* Called with zone->lock held, the stats are stable */
+	{
+		u64 avg = zone->lock_stat.hold_total;
+
+		if (zone->lock_stat.nr)
+			do_div(avg, zone->lock_stat.nr);
+		seq_printf(m,
+			   "\n  lock_acquired:     %lu"
+			   "\n  lock_hold_avg_ns:  %llu"
+			   "\n  lock_hold_max_ns:  %llu",
+			   zone->lock_stat.nr, (unsigned long long)avg,
+			   (unsigned long long)zone->lock_stat.hold_max);
+	}
+#endif
 	seq_putc(m, '\n');
 }
 
@@ -0,0 +1,209 @@
+/*
+ * Workingset detection
+ *
+ * Page cache reclaim only looks at the ratio between the active and the
+ * inactive file lists, so a single large streaming read can push the
+ * whole inactive list, and with it pages that would have been promoted
+ * soon, out of memory before they are referenced a second time.
+ *
+ * To tell a page that is part of the working set from one that merely
+ * passed through, every evicted file page leaves a shadow behind: the
+ * zone it lived in and the value of that zone's inactive_age counter at
+ * the time.  inactive_age advances on every eviction and every
+ * activation, so when the page is faulted back in, the difference
+ *
+ *	refault_distance = inactive_age(now) - inactive_age(eviction)
+ *
+ * is the number of slots the inactive list would have needed on top of
+ * what it had for the page to still be resident.  Those slots can only
+ * come out of the active list, so if the refault distance is smaller
+ * than the active list, the page is activated straight away and gets to
+ * compete with the current working set.  Otherwise it starts out on the
+ * inactive list as usual.
+ *
+ * The radix tree here cannot hold anything but pages, so shadows live in
+ * a separate hash of non-resident pages keyed by mapping and index.  Each
+ * bucket is a tiny clock: a new shadow overwrites the oldest one in its
+ * bucket.  A lookup consumes the shadow.  Entries of truncated files are
+ * not removed, they are simply overwritten over time; the occasional
+ * stale hit only costs an activation.
+ */
+
+#include <linux/mm.h>
+#include <linux/mmzone.h>
+#include <linux/init.h>
+#include <linux/bootmem.h>
+#include <linux/hash.h>
+#include <linux/log2.h>
+#include <linux/spinlock.h>
+#include <linux/swap.h>
+#include <linux/vmstat.h>
+
+#define SHADOW_SLOTS		6
+
+struct shadow_bucket {
+	spinlock_t	lock;
+	unsigned int	hand;
+	unsigned long	slot[SHADOW_SLOTS];
+};
+
+static struct shadow_bucket *shadow_table __read_mostly;
+static unsigned int shadow_hash_shift __read_mostly;
+
+/*
+ * A shadow entry packs, from the bottom up: a valid bit, a cookie made of
+ * hash bits that did not go into the bucket index, the zone, and as many
+ * bits of the eviction age as are left.
+ */
+#define SHADOW_COOKIE_BITS	8
+#define SHADOW_ZONE_BITS	(NODES_SHIFT + ZONES_SHIFT)
+#define SHADOW_AGE_SHIFT	(1 + SHADOW_COOKIE_BITS + SHADOW_ZONE_BITS)
+#define SHADOW_AGE_MASK		(~0UL >> SHADOW_AGE_SHIFT)
+
+static unsigned long shadow_key(struct address_space *mapping, pgoff_t index)
+{
+	return hash_long(hash_ptr(mapping, BITS_PER_LONG) ^ index,
+			 BITS_PER_LONG);
+}
+
+static struct shadow_bucket *shadow_bucket(unsigned long key)
+{
+	return &shadow_table[key >> (BITS_PER_LONG - shadow_hash_shift)];
+}
+
+static unsigned long shadow_cookie(unsigned long key)
+{
+	return key & ((1UL << SHADOW_COOKIE_BITS) - 1);
+}
+
+static unsigned long pack_shadow(unsigned long key, struct zone *zone,
+				 unsigned long eviction)
+{
+	unsigned long entry;
+
+	entry = eviction & SHADOW_AGE_MASK;
+	entry = (entry << NODES_SHIFT) | zone_to_nid(zone);
+	entry = (entry << ZONES_SHIFT) | zone_idx(zone);
+	entry = (entry << SHADOW_COOKIE_BITS) | shadow_cookie(key);
+	return (entry << 1) | 1;
+}
+
+static void unpack_shadow(unsigned long entry, struct zone **zone,
+			  unsigned long *eviction)
+{
+	int zid, nid;
+
+	entry >>= 1 + SHADOW_COOKIE_BITS;
+	zid = entry & ((1UL << ZONES_SHIFT) - 1);
+	entry >>= ZONES_SHIFT;
+	nid = entry & ((1UL << NODES_SHIFT) - 1);
+	entry >>= NODES_SHIFT;
+
+	*zone = NODE_DATA(nid)->node_zones + zid;
+	*eviction = entry;
+}
+
+static bool shadow_matches(unsigned long entry, unsigned long key)
+{
+	return (entry & 1) &&
+	       ((entry >> 1) & ((1UL << SHADOW_COOKIE_BITS) - 1)) ==
+	       shadow_cookie(key);
+}
+
+/**
+ * workingset_eviction - note the eviction of a page from the page cache
+ * @mapping: address space the page was removed from
+ * @page: the page being evicted
+ *
+ * Called after @page was taken out of @mapping by reclaim.  @mapping is
+ * only used as a hash key and is not dereferenced.
+ */
+void workingset_eviction(struct address_space *mapping, struct page *page)
+{
+	struct zone *zone = page_zone(page);
+	unsigned long key = shadow_key(mapping, page->index);
+	struct shadow_bucket *b = shadow_bucket(key);
+	unsigned long eviction;
+
+	eviction = atomic_long_inc_return(&zone->inactive_age);
+
+	spin_lock(&b->lock);
+	b->slot[b->hand] = pack_shadow(key, zone, eviction);
+	if (++b->hand == SHADOW_SLOTS)
+		b->hand = 0;
+	spin_unlock(&b->lock);
+}
+
+/**
+ * workingset_refault - evaluate the refault of a previously evicted page
+ * @mapping: address space the page is being added to
+ * @index: offset of the page in @mapping
+ *
+ * Looks up and consumes the shadow of @index in @mapping, if any, and
+ * returns true if the page should be activated right away because its
+ * refault distance shows it belongs to the working set.
+ */
+bool workingset_refault(struct address_space *mapping, pgoff_t index)
+{
+	unsigned long key = shadow_key(mapping, index);
+	struct shadow_bucket *b = shadow_bucket(key);
+	unsigned long entry = 0, eviction, refault_distance;
+	struct zone *zone;
+	int i;
+
+	spin_lock(&b->lock);
+	for (i = 0; i < SHADOW_SLOTS; i++) {
+		if (shadow_matches(b->slot[i], key)) {
+			entry = b->slot[i];
+			b->slot[i] = 0;
+			break;
+		}
+	}
+	spin_unlock(&b->lock);
+
+	if (!entry)
+		return false;
+
+	unpack_shadow(entry, &zone, &eviction);
+	refault_distance = (atomic_long_read(&zone->inactive_age) - eviction) &
+			   SHADOW_AGE_MASK;
+
+	inc_zone_state(zone, WORKINGSET_REFAULT);
+
+	if (refault_distance <= zone_page_state(zone, NR_ACTIVE_FILE)) {
+		inc_zone_state(zone, WORKINGSET_ACTIVATE);
+		return true;
+	}
+	return false;
+}
+
+/**
+ * workingset_activation - note a page activation
+ * @page: page that is being activated
+ */
+void workingset_activation(struct page *page)
+{
+	atomic_long_inc(&page_zone(page)->inactive_age);
+}
+
+static int __init workingset_init(void)
+{
+	unsigned long nr_buckets, i;
+
+	/* Remember about one evicted page for every two pages of memory */
+	nr_buckets = max_t(unsigned long,
+			   totalram_pages / (2 * SHADOW_SLOTS),
+			   PAGE_SIZE / sizeof(struct shadow_bucket));
+	shadow_table = alloc_large_system_hash("Workingset shadow",
+					sizeof(struct shadow_bucket),
+					nr_buckets, 0, 0,
+					&shadow_hash_shift, NULL, 0);
+
+	/* The table is not zeroed: empty slots and hands start out as 0 */
+	memset(shadow_table, 0,
+	       sizeof(struct shadow_bucket) << shadow_hash_shift);
+	for (i = 0; i < (1UL << shadow_hash_shift); i++)
+		spin_lock_init(&shadow_table[i].lock);
+	return 0;
+}
+core_initcall(workingset_init);